@@ -1,11 +1,17 @@
 #pragma once
 
 #include <league_lib/bin/bin_valuestorage.hpp>
+#include <league_lib/util/arena.hpp>
+#include <league_lib/util/string_pool.hpp>
 
+#include <array>
+#include <atomic>
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
 
 #include <spek/file/file.hpp>
 
@@ -15,32 +21,194 @@ namespace LeagueLib
 	{
 	public:
 		using OnLoadFunction = std::function<void(LeagueLib::Bin& bin)>;
-		Bin() = default;
+
+		// Location of a root entry in the file, collected when loading.
+		struct Entry
+		{
+			u32 hash;
+			u32 typeHash;
+			size_t offset; // Offset of the entry's hash, right after its length
+			u32 length;
+		};
+
+		// Everything in front of the root entries, and where the entries are.
+		struct Header
+		{
+			u32 version = 0;
+			std::vector<std::string> linkedFiles;
+			std::vector<u32> typeArray;
+			std::vector<Entry> entries;
+			size_t startOffset = 0; // Offset of the first entry's length
+		};
+
+		enum LoadFlags
+		{
+			NoLoadFlags = 0,
+
+			// String values point straight into the file's data, instead of being copied into the bin's arena.
+			// Only use this if the file isn't reloaded while its values are in use.
+			ViewFileStrings = 1 << 0,
+
+			// Structs, containers and maps are skipped using their length, and only parsed once they're accessed.
+			LazyNodes = 1 << 1,
+
+			// Keeps a checksum of every entry, so that a reload only parses the entries again that have changed. Values
+			// of the other entries stay where they are, so references to them stay valid. Changed entries get a new
+			// value, which lookups return from then on, while references to the previous value stay valid and keep
+			// showing it, so other threads can keep reading during a reload. The memory of replaced values is only
+			// released by Reset. Has no effect with ViewFileStrings, as those values point into the file.
+			// With LazyNodes, every load keeps a copy of the file's data until Reset, to parse those values' nodes from.
+			IncrementalReload = 1 << 2,
+
+			// String values are copied into StringPool::GetDefault() instead of the bin's arena, so strings that many
+			// bins share are only stored once. They stay valid after the bin is reset. Has no effect with ViewFileStrings.
+			InternStrings = 1 << 3,
+		};
+
+		// How a root entry differs from the previous load, see IncrementalReload.
+		struct EntryChange
+		{
+			enum class Kind : u8
+			{
+				Added,
+				Changed,
+				Removed
+			};
+
+			u32 hash;
+			Kind kind;
+		};
+
+		struct ArenaUsage
+		{
+			size_t usedBytes;
+			size_t reservedBytes;
+		};
+
+		Bin();
 		~Bin();
 
-		void Load(const std::string& filePath, OnLoadFunction onLoadFunction = nullptr);
+		void Load(const std::string& filePath, OnLoadFunction onLoadFunction = nullptr, u32 loadFlags = NoLoadFlags);
 		Spek::File::LoadState GetLoadState() const { return m_loadState; }
 		const std::vector<std::string>& GetLinkedFiles() const { return m_linkedFiles; }
 		std::string GetFileName() const { return m_file->GetName(); }
+		const Spek::File::Handle& GetFile() const { return m_file; }
+
+		// The entries are replaced by every load, so don't hold on to them or the pointers below across one.
+		const std::vector<Entry>& GetEntries() const;
+		const Entry* FindEntry(u32 hash) const;
+
+		// The entries that were added, changed or removed by the last load, if the bin was loaded with IncrementalReload.
+		const std::vector<EntryChange>& GetChangedEntries() const { return m_changedEntries; }
+
+		// Entries of a class, found through the type array without parsing anything.
+		std::vector<const Entry*> GetEntriesOfType(u32 typeHash) const;
+		std::vector<const Entry*> GetEntriesOfType(BinFieldKey typeKey) const { return GetEntriesOfType(typeKey.hash); }
 
+		// Reads the header and entry locations of a PROP file. Returns false if data isn't one, or has an entry that is too
+		// short to hold its hash and field count.
+		static bool ReadHeader(const u8* data, size_t size, Header& header);
+
+		// Safe to call from any number of threads at once, also while the bin is being loaded or reset. Entries that were
+		// parsed before are returned without locking. A load or reset that doesn't keep the values frees them though, so
+		// the returned references are only valid until then. The file system rewrites the file before the bin hears about
+		// a reload, so an entry that is being parsed right then can still read parts of both versions.
 		const BinVariable& operator[](u32 hash) const;
 		const BinVariable& operator[](std::string_view name) const;
+		const BinVariable& operator[](BinFieldKey key) const;
+
+		// Parses every root entry that hasn't been parsed yet, spread over the default thread pool.
+		void ParseAll();
+
+		// Parses the entries of a class that haven't been parsed yet, leaving the others alone.
+		void ParseEntriesOfType(u32 typeHash);
+		void ParseEntriesOfType(BinFieldKey typeKey) { ParseEntriesOfType(typeKey.hash); }
+
+		// Memory used by the parsed entries, summed over all arenas of this bin.
+		ArenaUsage GetArenaUsage() const;
 
+		// Frees the parsed entries. The arenas are released at once, but every parsed node is still visited, see ClearRoot.
 		void Reset();
 
 	private:
-		BinObject m_root;
+		// Entries that are accessed before they're parsed are parsed under the lock of one of these, into its arena, so
+		// threads only wait for each other if they need entries of the same shard.
+		struct ParseShard
+		{
+			std::mutex mutex;
+			Arena arena;
+		};
+		static constexpr size_t ParseShardCount = 16;
+
+		// Everything a lookup reads. Every load builds a new one aside, which is published all at once, see PublishIndex.
+		struct EntryIndex
+		{
+			u32 generation = 0; // The m_indexGeneration it was published in
+			std::vector<Entry> entries;
+			std::unordered_map<u32, u32> entryIndices;
+			std::unordered_map<u32, std::vector<u32>> typeIndices;
+			std::vector<u64> entryChecksums;
+
+			// The parsed value of every entry, at the index of the first entry with its hash. A slot is only set once
+			// for every index, so it can be read without locking.
+			std::vector<std::atomic<const BinVariable*>> slots;
+		};
+
+		// Lookups count themselves in one of these while they use the index, spread over them by thread. The counts are
+		// split by the parity of the generation of the index they use, so a load can wait for the lookups that might
+		// still use the previous index, while new lookups count in the other half.
+		struct alignas(64) ReaderCount
+		{
+			std::atomic<u32> counts[2] = {};
+		};
+
+		class IndexReader;
+		class ExclusiveLock;
+
+		// Parsed values are allocated from these, and freed all at once when the bin is reset or reloaded.
+		// ParseAll hands every worker its own arena, as they are not thread-safe.
+		std::array<ParseShard, ParseShardCount> m_parseShards;
+		std::vector<std::unique_ptr<Arena>> m_workerArenas;
+
+		class LazySource;
+		std::unique_ptr<LazySource> m_lazySource; // Of the last load, with LazyNodes
+		std::vector<std::unique_ptr<LazySource>> m_retiredLazySources; // Of earlier loads, for the values they still have
+
+		// Parsed root entries. This is node based, so references handed out stay valid while others are added.
+		// It's only changed with m_mutex locked, and read through the slots of the index.
+		std::unordered_map<u32, BinVariable> m_root;
+		std::vector<std::unordered_map<u32, BinVariable>::node_type> m_replacedValues; // See IncrementalReload
+
+		// The index of every generation is published in the half of its parity. Only changed with every lock of
+		// ExclusiveLock held, lookups go through IndexReader.
+		std::unique_ptr<EntryIndex> m_currentIndex;
+		std::array<std::atomic<EntryIndex*>, 2> m_publishedIndices = {};
+		std::atomic<u32> m_indexGeneration = 0;
+		mutable std::array<ReaderCount, ParseShardCount> m_readerCounts;
+
 		std::vector<std::string> m_linkedFiles;
 		std::vector<u32> m_typeArray;
+		std::vector<EntryChange> m_changedEntries;
 		std::mutex m_mutex;
 
-		size_t m_offset = 0;
 		size_t m_startOffset = 0;
 		u32 m_entryCount = 0;
+		u32 m_loadFlags = NoLoadFlags;
 
 		Spek::File::Handle m_file = nullptr;
 		Spek::File::LoadState m_loadState = Spek::File::LoadState::NotLoaded;
 
-		const BinVariable& Find(u32 hash);
+		const BinVariable* Find(EntryIndex& index, u32 slot);
+		BinObject ParseEntry(const Entry& entry, std::pmr::memory_resource* resource) const;
+		void ParseEntries(EntryIndex& index, const std::vector<const Entry*>& entries, bool replace = false);
+		const BinVariable& StoreEntry(EntryIndex& index, u32 slot, BinVariable&& value, bool replace);
+		void LinkSlots(EntryIndex& index);
+		std::unique_ptr<EntryIndex> BuildIndex(std::vector<Entry>&& entries, const std::vector<u8>& data) const;
+		std::unique_ptr<EntryIndex> PublishIndex(std::unique_ptr<EntryIndex> index);
+		void RetireIndex(std::unique_ptr<EntryIndex> index);
+		const EntryIndex* GetPublishedIndex() const { return m_publishedIndices[m_indexGeneration.load() & 1].load(); }
+		void ApplyChanges(const EntryIndex* previousIndex, EntryIndex& index, bool canKeepValues);
+		void ClearRoot();
+		StringPool* GetStringPool() const { return (m_loadFlags & InternStrings) ? &StringPool::GetDefault() : nullptr; }
 	};
 }
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <league_lib/wad/wad.hpp>
+
+#include <functional>
+#include <vector>
+
+namespace LeagueLib
+{
+	class WADFileSystem;
+
+	// The bins in one or two sets of archives, such as the archives of the game before and after a patch. This is what
+	// BinTypeScan, BinTextWriter and BinDiff use to go through every bin of the game.
+	// The file list is collected up front, so that the extraction, which is the expensive part, can be spread out.
+	class BinArchiveFiles
+	{
+	public:
+		// Return false to skip a file without extracting it, for example when a hash dictionary says it isn't a bin.
+		using FileFilterFunction = std::function<bool(const WAD& archive, WAD::FileNameHash fileHash)>;
+
+		struct File
+		{
+			WAD::FileNameHash hash;
+			const WAD* archives[2] = {};	// The archive of each set that has the file, or nullptr
+		};
+
+		// Called from the default thread pool with the data of the file in each set, which is empty if the set doesn't
+		// have it. The data is only valid during the call. Return true to count the file.
+		using OnFileFunction = std::function<bool(const File& file, const std::vector<u8> (&data)[2])>;
+
+		// Files that are in more than one archive of a set are taken from the first.
+		BinArchiveFiles(const std::vector<const WAD*>& archives, const FileFilterFunction& filter = nullptr);
+		BinArchiveFiles(const std::vector<const WAD*>& archives, const std::vector<const WAD*>& otherArchives, const FileFilterFunction& filter = nullptr);
+
+		static std::vector<const WAD*> GetArchives(const WADFileSystem& fileSystem);
+
+		// Extracts the file if it's a PROP file. Only the start of other files is decompressed, to check their magic.
+		static bool ExtractBin(const WAD& archive, WAD::FileNameHash fileHash, std::vector<u8>& data);
+
+		const std::vector<File>& GetFiles() const { return m_files; }
+
+		// Calls onFile in parallel for every file that is a bin in each set that has it, returning the number of files
+		// it returned true for. Files with the same checksum in both sets are skipped, as they can't differ.
+		size_t ForEach(const OnFileFunction& onFile) const;
+
+	private:
+		void AddFiles(const std::vector<const WAD*>& archives, size_t set, const FileFilterFunction& filter);
+
+		std::vector<File> m_files;
+	};
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <league_lib/bin/bin.hpp>
+#include <league_lib/bin/bin_type.hpp>
+#include <league_lib/util/hash.hpp>
+#include <league_lib/util/mapped_file.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LeagueLib
+{
+	class BinCache;
+
+	// A value in a BinCache, pointing straight into the cache. Only valid while the cache stays loaded.
+	// Accessing something that isn't there results in a node where IsValid() is false, like BinVariable.
+	class BinCacheNode
+	{
+	public:
+		BinCacheNode() = default;
+
+		bool IsValid() const { return m_cache != nullptr; }
+		BinType GetType() const { return m_type; }
+
+		// The name of a field, or the hash of an entry. 0 for elements, keys and values.
+		u32 GetNameHash() const;
+
+		// The class of a struct or entry, 0 for null structs.
+		u32 GetTypeHash() const;
+
+		// Element type of containers and arrays, key and value type of maps.
+		BinType GetElementType() const;
+		BinType GetKeyType() const { return GetElementType(); }
+		BinType GetValueType() const;
+
+		// Fields of structs, elements of containers and arrays, pairs of maps.
+		size_t size() const;
+
+		BinCacheNode operator[](size_t index) const;
+		BinCacheNode operator[](std::string_view name) const;
+		BinCacheNode operator[](BinFieldKey key) const;
+
+		// Fields of structs by index, in the order of the file.
+		BinCacheNode GetField(size_t index) const;
+
+		// Pairs of maps by index, in the order of the file.
+		BinCacheNode GetKey(size_t index) const;
+		BinCacheNode GetValue(size_t index) const;
+
+		// The value of a map, for integer, hash and path keys or for string keys. Field keys also match maps that store
+		// hashes as i32 keys.
+		BinCacheNode Find(u64 key) const;
+		BinCacheNode Find(std::string_view key) const;
+		BinCacheNode Find(BinFieldKey key) const { return Find(GetKeyType() == BinType::S32 ? (u64)(i64)(i32)key.hash : (u64)key.hash); }
+
+		// The value as it is in the file, see IsNativeBinType.
+		template<typename T>
+		const T* As() const
+		{
+			return IsNativeBinType<T>(m_type) ? reinterpret_cast<const T*>(m_data) : nullptr;
+		}
+
+		std::string_view GetString() const;
+
+		// The elements of a container or array of fixed-size values.
+		template<typename T>
+		BinSpan<T> AsSpan() const
+		{
+			if (IsTypedArray() == false || IsNativeBinType<T>(GetElementType()) == false)
+				return BinSpan<T>();
+			return BinSpan<T>(reinterpret_cast<const T*>(m_data), size());
+		}
+
+	private:
+		friend class BinCache;
+		struct Node;
+
+		BinCacheNode(const BinCache& cache, const Node& node);
+		BinCacheNode(const BinCache& cache, BinType type, const u8* data) : m_cache(&cache), m_data(data), m_type(type) {}
+
+		bool IsTypedArray() const;
+		BinCacheNode GetChild(size_t index) const;
+
+		const BinCache* m_cache = nullptr;
+		const Node* m_node = nullptr; // nullptr for the elements of a typed array
+		const u8* m_data = nullptr; // Values, strings and typed arrays
+		BinType m_type = BinType::Empty;
+	};
+
+	// A PROP file converted into a layout that can be used without parsing, to skip parsing bins that haven't changed.
+	// Every value is a fixed-size node with offsets to its children, its value, or its string in a shared pool, so the
+	// cache is the same in memory and on disk and a saved one is mapped as it is. Fixed-size elements are stored as
+	// typed arrays. A cache knows the checksum of the file it was built from, see GetSourceChecksum.
+	class BinCache
+	{
+	public:
+		BinCache() = default;
+		BinCache(const BinCache&) = delete;
+		BinCache& operator=(const BinCache&) = delete;
+
+		// Returns false if data isn't a valid PROP file. The bin has to be loaded.
+		bool Build(const u8* data, size_t size);
+		bool Build(const Bin& bin);
+
+		bool Save(const std::string& path) const;
+
+		// Maps a saved cache. Returns false if it can't be read, or if it was built from a different file.
+		bool Load(const std::string& path);
+		bool Load(const std::string& path, u64 sourceChecksum);
+
+		// Loads the cache at path if it was built from data, otherwise builds it and saves it there.
+		bool LoadOrBuild(const std::string& path, const u8* data, size_t size);
+		bool LoadOrBuild(const std::string& path, const Bin& bin);
+
+		static u64 GetSourceChecksum(const u8* data, size_t size) { return HashData(data, size); }
+
+		bool IsValid() const { return m_data != nullptr; }
+		u64 GetSourceChecksum() const;
+		u32 GetVersion() const;
+
+		size_t GetLinkedFileCount() const;
+		std::string_view GetLinkedFile(size_t index) const;
+
+		// Root entries, sorted by hash. Entries act like embedded structs.
+		size_t size() const;
+		BinCacheNode GetEntry(size_t index) const;
+
+		BinCacheNode operator[](u32 hash) const;
+		BinCacheNode operator[](std::string_view name) const;
+		BinCacheNode operator[](BinFieldKey key) const { return operator[](key.hash); }
+
+	private:
+		friend class BinCacheNode;
+		struct Header;
+		struct LinkedFile;
+		struct Entry;
+		class Builder;
+
+		// Points the sections into data, if it holds a valid cache.
+		bool Map(const u8* data, size_t size);
+		void Reset();
+
+		// Either points into m_buffer, after a build, or into m_file after a load.
+		std::vector<u8> m_buffer;
+		MappedFile m_file;
+		const u8* m_data = nullptr;
+		size_t m_size = 0;
+
+		const Header* m_header = nullptr;
+		const LinkedFile* m_linkedFiles = nullptr;
+		const Entry* m_entries = nullptr;
+		const BinCacheNode::Node* m_nodes = nullptr;
+		const u8* m_values = nullptr;
+		const char* m_strings = nullptr;
+	};
+}
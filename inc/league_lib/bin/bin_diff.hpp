@@ -0,0 +1,78 @@
+#pragma once
+
+#include <league_lib/bin/bin.hpp>
+#include <league_lib/bin/bin_archive_files.hpp>
+#include <league_lib/bin/bin_parser.hpp>
+#include <league_lib/wad/wad.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace LeagueLib
+{
+	class WADFileSystem;
+
+	// Finds the differences between two versions of a PROP file, such as a bin before and after a patch.
+	// Entries, fields, elements and map values are all stored with their length, so anything whose bytes are the same
+	// in both files is skipped as a whole, and only the parts that differ are taken apart.
+	class BinDiff
+	{
+	public:
+		struct Step
+		{
+			enum class Kind : u8
+			{
+				Field,
+				Index,
+				Key
+			};
+
+			Kind kind;
+			u32 hash = 0;			// Field
+			u32 index = 0;			// Index
+			BinValueView key = {};	// Key
+		};
+
+		struct Change
+		{
+			enum class Kind : u8
+			{
+				Added,
+				Removed,
+				Modified
+			};
+
+			Kind kind;
+			u32 entryHash;
+
+			// From the entry to the value that changed. Empty when the entry itself was added, removed or changed class.
+			std::vector<Step> path;
+
+			// The values as they are in the files, or type Empty for added and removed values.
+			// Structs, containers and maps are given as a whole.
+			BinValueView oldValue = {};
+			BinValueView newValue = {};
+		};
+
+		// Called from the default thread pool for every bin that changed. The values of the changes point into the
+		// files, which are only valid during the call.
+		using OnFileFunction = std::function<void(WAD::FileNameHash fileHash, const std::vector<Change>& changes)>;
+		using FileFilterFunction = BinArchiveFiles::FileFilterFunction;
+
+		// Changes are in the order of the new file, followed by the removed entries. Empty data counts as a file
+		// without entries. Returns false if either isn't a PROP file.
+		static bool Diff(const u8* oldData, size_t oldSize, const u8* newData, size_t newSize, std::vector<Change>& changes);
+		static bool Diff(const Bin& oldBin, const Bin& newBin, std::vector<Change>& changes);
+
+		// Diffs every bin that is in either set of archives in parallel, returning the number of bins that changed.
+		// Files that are in more than one archive of a set are taken from the first, and files with the same checksum
+		// in both sets aren't extracted at all. The filter is called for the files of both sets.
+		static size_t Diff(const std::vector<const WAD*>& oldArchives, const std::vector<const WAD*>& newArchives, const OnFileFunction& onFile, const FileFilterFunction& filter = nullptr);
+		static size_t Diff(const WADFileSystem& oldFileSystem, const WADFileSystem& newFileSystem, const OnFileFunction& onFile, const FileFilterFunction& filter = nullptr);
+
+		// The path of a change as a BinQuery path, with every name as a hash: 0x1a2b3c4d.0x5e6f7a8b[2]{"key"}
+		// BinQuery::Compile turns it back into a query for the value.
+		static std::string GetPath(const Change& change);
+	};
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <league_lib/bin/bin.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace LeagueLib
+{
+	// Loads bins together with every bin they link to, directly or through other linked bins.
+	// The linked files of a bin are requested as soon as it has loaded, so every level of links is loaded as a single
+	// batch. Files that are linked more than once are only loaded once.
+	class BinGraph
+	{
+	public:
+		using OnLoadFunction = std::function<void(LeagueLib::BinGraph& graph)>;
+
+		enum LoadFlags
+		{
+			NoLoadFlags = 0,
+
+			// Parses every bin on the default thread pool, before the load function is called.
+			ParseBins = 1 << 0,
+		};
+
+		BinGraph() = default;
+		BinGraph(const BinGraph&) = delete;
+		~BinGraph();
+		BinGraph& operator=(const BinGraph&) = delete;
+
+		// onLoad is called once, after every bin has either loaded or failed to. binLoadFlags are passed to every Bin.
+		// Loads that are still pending when the graph is loaded again, reset or destroyed are ignored once they finish.
+		void Load(const std::string& path, OnLoadFunction onLoad = nullptr, u32 loadFlags = ParseBins, u32 binLoadFlags = Bin::NoLoadFlags);
+		void Load(const std::vector<std::string>& paths, OnLoadFunction onLoad = nullptr, u32 loadFlags = ParseBins, u32 binLoadFlags = Bin::NoLoadFlags);
+
+		// Loaded if all of the requested bins loaded, even if some of the bins they link to didn't.
+		Spek::File::LoadState GetLoadState() const { return m_loadState; }
+		const std::vector<std::string>& GetFailedFiles() const { return m_failedFiles; }
+
+		// The requested bins come first, followed by the linked bins in the order they were found.
+		std::vector<const Bin*> GetBins() const;
+		const Bin* GetBin(std::string_view path) const;
+
+		// The bin that has a root entry, or the first one if more than one bin has it.
+		const Bin* FindBin(u32 hash) const;
+
+		const BinVariable& operator[](u32 hash) const;
+		const BinVariable& operator[](std::string_view name) const;
+		const BinVariable& operator[](BinFieldKey key) const;
+
+		void Reset();
+
+	private:
+		// Nodes are shared with the load callbacks of their bins, which the files keep around after the graph has let go.
+		struct Node
+		{
+			std::string path;
+			Bin bin;
+			BinGraph* graph = nullptr; // Cleared when the graph lets go of the node
+			bool isResolved = false;
+		};
+
+		// Returns nullptr if the graph already has the bin.
+		std::shared_ptr<Node> AddNode(const std::string& path);
+		void StartLoad(const std::shared_ptr<Node>& node);
+		void OnBinLoaded(Node& node);
+		void Finish();
+
+		std::vector<std::shared_ptr<Node>> m_nodes;
+		std::unordered_map<std::string, size_t> m_nodeIndices;
+		std::unordered_map<u32, size_t> m_entryOwners;
+		std::vector<std::string> m_failedFiles;
+
+		size_t m_rootCount = 0;
+		size_t m_pendingCount = 0;
+		u32 m_loadFlags = NoLoadFlags;
+		u32 m_binLoadFlags = Bin::NoLoadFlags;
+		OnLoadFunction m_onLoad;
+
+		Spek::File::LoadState m_loadState = Spek::File::LoadState::NotLoaded;
+	};
+}
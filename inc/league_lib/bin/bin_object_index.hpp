@@ -0,0 +1,83 @@
+#pragma once
+
+#include <league_lib/bin/bin.hpp>
+#include <league_lib/util/mapped_file.hpp>
+#include <league_lib/wad/wad.hpp>
+
+#include <string>
+#include <vector>
+
+namespace LeagueLib
+{
+	class WADFileSystem;
+
+	// Knows which bin holds every root entry in a set of archives, so links can be resolved without loading bins.
+	// The index is stored in the same layout in memory and on disk, which lets a saved index be mapped as it is.
+	// A saved index is only used while every archive still has the same name and checksum.
+	class BinObjectIndex
+	{
+	public:
+		struct Location
+		{
+			u64 pathHash;		// Bin that holds the entry
+			u32 rootHash;
+			u32 classHash;
+			u32 entryOffset;	// Offset of the entry's hash in the bin
+			u32 entryLength;
+			u32 archiveIndex;	// Index in the archives the index was built from
+			u32 padding;
+
+			Bin::Entry GetEntry() const { return { rootHash, classHash, entryOffset, entryLength }; }
+		};
+
+		BinObjectIndex() = default;
+		BinObjectIndex(const BinObjectIndex&) = delete;
+		BinObjectIndex& operator=(const BinObjectIndex&) = delete;
+
+		// Scans every bin of the archives in parallel. Archives have to be parsed.
+		void Build(const std::vector<const WAD*>& archives);
+		void Build(const WADFileSystem& fileSystem);
+
+		bool Save(const std::string& path) const;
+
+		// Maps a saved index. Returns false if it can't be read, or if it was built from other archives.
+		bool Load(const std::string& path, const std::vector<const WAD*>& archives);
+		bool Load(const std::string& path, const WADFileSystem& fileSystem);
+
+		// Loads the index at path if it's still valid, otherwise builds it and saves it there.
+		void LoadOrBuild(const std::string& path, const WADFileSystem& fileSystem);
+
+		bool IsValid() const { return m_data != nullptr; }
+		size_t size() const;
+
+		// If more than one bin has the entry, this is the one in the first archive.
+		const Location* Find(u32 rootHash) const;
+		const Location* Find(BinFieldKey key) const { return Find(key.hash); }
+		std::vector<const Location*> FindAll(u32 rootHash) const;
+
+		const WAD* GetArchive(const Location& location) const;
+
+		// Extracts the bin that holds location, use location.GetEntry() to read the entry from it.
+		bool ExtractBin(const Location& location, std::vector<u8>& data) const;
+
+	private:
+		struct Header;
+		struct Archive;
+
+		const Header& GetHeader() const;
+		const Archive* GetArchives() const;
+		const Location* GetLocations() const;
+		const u32* GetSlots() const;
+
+		bool Validate(const std::vector<const WAD*>& archives) const;
+		void Reset();
+
+		// Either points into m_buffer, after a build, or into m_file after a load.
+		std::vector<u8> m_buffer;
+		MappedFile m_file;
+		const u8* m_data = nullptr;
+		size_t m_size = 0;
+
+		std::vector<const WAD*> m_archives;
+	};
+}
@@ -1,13 +1,100 @@
 #pragma once
 
+#include <league_lib/bin/bin_type.hpp>
+
+#include <spek/file/file.hpp>
+
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+
 namespace LeagueLib
 {
-	class BinVariable;
+	// A value as it's stored in the file. The data points into the buffer that is being parsed.
+	struct BinValueView
+	{
+		BinType type;
+		const u8* data;
+		size_t size;
+
+		template<typename T>
+		T Get() const
+		{
+			assert(sizeof(T) <= size);
+			T result;
+			memcpy(&result, data, sizeof(T));
+			return result;
+		}
+
+		// Only valid for strings, which start with their length.
+		std::string_view GetString() const { return std::string_view((const char*)data + sizeof(u16), size - sizeof(u16)); }
+	};
+
+	// Receives the events of a BinParser. Everything is ignored by default, so only override what you need.
+	// Skipping a struct, container or map skips its contents, and its end event is not sent.
+	class BinVisitor
+	{
+	public:
+		enum Action
+		{
+			Enter,
+			Skip,
+			Stop
+		};
+
+		virtual ~BinVisitor() = default;
+
+		virtual Action OnLinkedFile(std::string_view /*name*/) { return Enter; }
+
+		virtual Action OnBeginEntry(u32 /*hash*/, u32 /*typeHash*/) { return Enter; }
+		virtual Action OnEndEntry(u32 /*hash*/) { return Enter; }
+
+		// Called for every field of an entry or struct, right before its value.
+		virtual Action OnField(u32 /*hash*/, BinType /*type*/) { return Enter; }
+		virtual Action OnValue(const BinValueView& /*value*/) { return Enter; }
+
+		// A typeHash of 0 is a null struct, which has no fields.
+		virtual Action OnBeginStruct(u32 /*typeHash*/) { return Enter; }
+		virtual Action OnEndStruct() { return Enter; }
+
+		// type is either Container, Container2 or Array.
+		virtual Action OnBeginContainer(BinType /*type*/, BinType /*elementType*/, u32 /*count*/) { return Enter; }
+		virtual Action OnEndContainer() { return Enter; }
+
+		// Keys and values are sent in turns.
+		virtual Action OnBeginMap(BinType /*keyType*/, BinType /*valueType*/, u32 /*count*/) { return Enter; }
+		virtual Action OnEndMap() { return Enter; }
+	};
+
+	// Walks a PROP file and sends its contents to a BinVisitor, without building any BinVariables.
 	class BinParser
 	{
 	public:
 		using OnLoadFunction = std::function<void(LeagueLib::BinParser& parser)>;
+
+		enum class Result
+		{
+			Finished,
+			Stopped,
+			Malformed
+		};
+
 		void Load(const std::string& filePath, OnLoadFunction onLoadFunction = nullptr);
+		Spek::File::LoadState GetLoadState() const { return m_loadState; }
+
+		Result Parse(BinVisitor& visitor) const;
+		static Result Parse(const u8* data, size_t size, BinVisitor& visitor);
+
+		// Parses a single value of type at offset, and moves offset past it.
+		static Result ParseValue(const u8* data, size_t size, size_t& offset, BinType type, BinVisitor& visitor);
+
+		// Moves offset past a value of type, using the length prefixes where possible. Returns false if it doesn't fit in size.
+		static bool SkipValue(const u8* data, size_t size, size_t& offset, BinType type);
 
+	private:
+		Spek::File::Handle m_file = nullptr;
+		Spek::File::LoadState m_loadState = Spek::File::LoadState::NotLoaded;
 	};
 }
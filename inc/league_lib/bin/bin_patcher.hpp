@@ -0,0 +1,89 @@
+#pragma once
+
+#include <league_lib/bin/bin.hpp>
+#include <league_lib/bin/bin_query.hpp>
+#include <league_lib/bin/bin_type.hpp>
+
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+namespace LeagueLib
+{
+	// Changes fixed-size values of a PROP file where they are, without parsing the file or writing it again.
+	// Values are found with a BinQuery, which uses the entry locations of the header and skips everything in front of
+	// a value using its length, so patching a few values costs about as much as reading the header.
+	class BinPatcher
+	{
+	public:
+		// Receives the type and the bytes of every value that matches, to change as they are.
+		using PatchFunction = std::function<bool(BinType type, u8* data)>;
+
+		// data is changed in place, so it has to stay alive while the patcher is used. Returns false if it isn't a PROP file.
+		bool Open(u8* data, size_t size);
+		bool Open(std::vector<u8>& data) { return Open(data.data(), data.size()); }
+		bool IsOpen() const { return m_data != nullptr; }
+		const Bin::Header& GetHeader() const { return m_header; }
+
+		// Calls patch for every fixed-size value the query matches, returning the number of values it returned true for.
+		size_t Patch(const BinQuery& query, const PatchFunction& patch);
+
+		// Sets every fixed-size value the query matches, returning the number of values that were set.
+		// Numbers are converted to the type in the file, and bools set bools and flags. Vectors, colours (glm::u8vec4)
+		// and matrices have to match the type in the file, other values are left alone.
+		template<typename T>
+		size_t Set(const BinQuery& query, const T& value)
+		{
+			return Patch(query, [&value](BinType type, u8* data) { return Encode(type, value, data); });
+		}
+
+		template<typename T>
+		size_t Set(std::string_view path, const T& value) { return Set(BinQuery::Compile(path), value); }
+
+	private:
+		template<typename FileType, typename T>
+		static bool Store(const T& value, u8* data)
+		{
+			FileType converted = static_cast<FileType>(value);
+			memcpy(data, &converted, sizeof(FileType));
+			return true;
+		}
+
+		template<typename T>
+		static bool Encode(BinType type, const T& value, u8* data)
+		{
+			if constexpr (std::is_same_v<T, bool>)
+			{
+				return (type == BinType::Bool || type == BinType::Flag) && Store<u8>(value, data);
+			}
+			else if constexpr (std::is_arithmetic_v<T>)
+			{
+				switch (type)
+				{
+				case BinType::S8:		return Store<i8>(value, data);
+				case BinType::U8:		return Store<u8>(value, data);
+				case BinType::S16:		return Store<i16>(value, data);
+				case BinType::U16:		return Store<u16>(value, data);
+				case BinType::S32:		return Store<i32>(value, data);
+				case BinType::U32:
+				case BinType::Hash:
+				case BinType::Link:		return Store<u32>(value, data);
+				case BinType::S64:		return Store<i64>(value, data);
+				case BinType::U64:
+				case BinType::Path:		return Store<u64>(value, data);
+				case BinType::Float:	return Store<float>(value, data);
+				default:				return false;
+				}
+			}
+			else
+			{
+				return IsNativeBinType<T>(type) && Store<T>(value, data);
+			}
+		}
+
+		u8* m_data = nullptr;
+		size_t m_size = 0;
+		Bin::Header m_header;
+	};
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <league_lib/bin/bin.hpp>
+#include <league_lib/bin/bin_parser.hpp>
+#include <league_lib/bin/bin_type.hpp>
+#include <league_lib/util/hash.hpp>
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LeagueLib
+{
+	// A path into the entries of a bin, with every name hashed up front so it can be evaluated over and over.
+	// Paths start with an entry name, followed by steps:
+	//     Spells/Annie/Q.mSpell.mDataValues[*].mValues[2]
+	//     *.mStats{"AttackDamage"}
+	// .name selects a field, .* every field, [n] an element, [*] every element or map value and {key} a map value.
+	// Map keys match string keys, or when quoted the hash of the name, otherwise they're read as a number.
+	// Quoted keys can contain any character, with a backslash in front of quotes and backslashes: {"a\"b"}
+	// Names can be given as a hash as well, like 0x1a2b3c4d.
+	class BinQuery
+	{
+	public:
+		struct Step
+		{
+			enum class Kind : u8
+			{
+				Field,
+				AnyField,
+				Index,
+				AnyElement,
+				Key
+			};
+
+			Kind kind;
+			u32 hash = 0;				// Field, or the name hash of a key
+			u32 index = 0;				// Index
+			u64 number = 0;				// Numeric keys, or the path hash of a key
+			bool isNumber = false;		// Key
+			std::string text;			// Key
+		};
+
+		struct Match
+		{
+			u32 entryHash;
+			BinValueView value;
+		};
+
+		// The matched value as it is in the file.
+		using OnValueFunction = std::function<void(u32 entryHash, const BinValueView& value)>;
+		using OnVariableFunction = std::function<void(u32 entryHash, const BinVariable& value)>;
+
+		// Matches every entry, add steps to narrow it down.
+		BinQuery() = default;
+
+		// Returns a query where IsValid() is false if the path can't be parsed.
+		static BinQuery Compile(std::string_view path);
+
+		BinQuery& Entry(std::string_view name);
+		BinQuery& Entry(u32 hash);
+		BinQuery& AnyEntry();
+		BinQuery& Field(std::string_view name);
+		BinQuery& Field(BinFieldKey key);
+		BinQuery& AnyField();
+		BinQuery& Index(u32 index);
+		BinQuery& AnyElement();
+		BinQuery& Key(std::string_view key);
+		BinQuery& Key(u64 key);
+
+		bool IsValid() const { return m_isValid; }
+		bool MatchesAnyEntry() const { return m_matchesAnyEntry; }
+		u32 GetEntryHash() const { return m_entryHash; }
+		const std::vector<Step>& GetSteps() const { return m_steps; }
+
+		// Works on the file data, skipping everything that doesn't match without parsing it.
+		// A query without steps matches the entries themselves, as a view over their field count and fields with type Empty.
+		void Evaluate(const Bin& bin, const OnValueFunction& onValue) const;
+
+		// Works on the data of a PROP file whose entries were found with Bin::ReadHeader.
+		void Evaluate(const u8* data, size_t size, const std::vector<Bin::Entry>& entries, const OnValueFunction& onValue) const;
+
+		// Works on the parsed values, parsing the entries it needs.
+		void EvaluateTree(const Bin& bin, const OnVariableFunction& onVariable) const;
+		void EvaluateTree(const BinVariable& root, const std::function<void(const BinVariable& value)>& onVariable) const;
+
+		// Evaluates the bins on the default thread pool, returning the matches of every bin in order.
+		std::vector<std::vector<Match>> EvaluateBatch(const std::vector<const Bin*>& bins) const;
+
+	private:
+		void EvaluateEntry(const u8* data, size_t size, const Bin::Entry& entry, const OnValueFunction& onValue) const;
+
+		std::vector<Step> m_steps;
+		u32 m_entryHash = 0;
+		bool m_matchesAnyEntry = true;
+		bool m_isValid = true;
+	};
+}
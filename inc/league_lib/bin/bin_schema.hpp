@@ -0,0 +1,412 @@
+#pragma once
+
+#include <league_lib/bin/bin.hpp>
+#include <league_lib/bin/bin_parser.hpp>
+#include <league_lib/bin/bin_type.hpp>
+#include <league_lib/util/hash.hpp>
+
+#include <glm/glm.hpp>
+#include <spek/util/hash.hpp>
+#include <spek/util/types.hpp>
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Decodes Bin structs straight into your own types, without building any BinVariables.
+// Bind a type by specialising BinBinding with a tuple of its fields:
+//
+//     template<> struct LeagueLib::BinBinding<ItemData>
+//     {
+//         static constexpr auto fields = std::make_tuple(
+//             BindBinField("itemID"_field, &ItemData::id),
+//             BindBinField(Spek::FNV("mName"), &ItemData::name));
+//     };
+//
+// Supported members are numbers, std::string(_view), glm vectors and mat4, std::vector, std::map, std::unordered_map,
+// and other bound types. Fields that aren't bound, or whose type in the file doesn't fit the member, are skipped.
+namespace LeagueLib
+{
+	template<typename T>
+	struct BinBinding
+	{
+	};
+
+	template<typename Class, typename Member>
+	struct BinFieldBinding
+	{
+		u32 hash;
+		Member Class::* member;
+	};
+
+	template<typename Class, typename Member>
+	constexpr BinFieldBinding<Class, Member> BindBinField(BinFieldKey key, Member Class::* member)
+	{
+		return { key.hash, member };
+	}
+
+	template<typename Class, typename Member>
+	constexpr BinFieldBinding<Class, Member> BindBinField(u32 hash, Member Class::* member)
+	{
+		return { hash, member };
+	}
+
+	template<typename T, typename = void>
+	constexpr bool HasBinBinding = false;
+
+	template<typename T>
+	constexpr bool HasBinBinding<T, std::void_t<decltype(BinBinding<T>::fields)>> = true;
+
+	namespace BinSchemaInternal
+	{
+		template<typename T>
+		constexpr bool AlwaysFalse = false;
+
+		template<typename T>
+		bool Read(const u8* data, size_t size, size_t& offset, T& value)
+		{
+			if (offset + sizeof(T) > size)
+				return false;
+
+			memcpy(&value, data + offset, sizeof(T));
+			offset += sizeof(T);
+			return true;
+		}
+	}
+
+	// Decodes a value of the given file type into T. Returns false if the data is malformed.
+	template<typename T, typename = void>
+	struct BinValueDecoder
+	{
+		static_assert(BinSchemaInternal::AlwaysFalse<T>, "This type can't be decoded from a Bin, bind it with BinBinding.");
+	};
+
+	template<typename T>
+	bool DecodeBinValue(const u8* data, size_t size, size_t& offset, BinType type, T& out)
+	{
+		return BinValueDecoder<T>::Decode(data, size, offset, type, out);
+	}
+
+	template<typename T>
+	struct BinValueDecoder<T, std::enable_if_t<std::is_arithmetic_v<T>>>
+	{
+		static bool Decode(const u8* data, size_t size, size_t& offset, BinType type, T& out)
+		{
+			switch (type)
+			{
+			case BinType::Bool:
+			case BinType::Flag:
+			case BinType::U8:		return DecodeAs<u8>(data, size, offset, out);
+			case BinType::S8:		return DecodeAs<i8>(data, size, offset, out);
+			case BinType::S16:		return DecodeAs<i16>(data, size, offset, out);
+			case BinType::U16:		return DecodeAs<u16>(data, size, offset, out);
+			case BinType::S32:		return DecodeAs<i32>(data, size, offset, out);
+			case BinType::U32:
+			case BinType::Hash:
+			case BinType::Link:		return DecodeAs<u32>(data, size, offset, out);
+			case BinType::S64:		return DecodeAs<i64>(data, size, offset, out);
+			case BinType::U64:
+			case BinType::Path:		return DecodeAs<u64>(data, size, offset, out);
+			case BinType::Float:	return DecodeAs<float>(data, size, offset, out);
+			default:				return BinParser::SkipValue(data, size, offset, type);
+			}
+		}
+
+	private:
+		template<typename FileType>
+		static bool DecodeAs(const u8* data, size_t size, size_t& offset, T& out)
+		{
+			FileType value;
+			if (BinSchemaInternal::Read(data, size, offset, value) == false)
+				return false;
+
+			out = static_cast<T>(value);
+			return true;
+		}
+	};
+
+	// Views point into the data that is being decoded.
+	template<typename T>
+	struct BinValueDecoder<T, std::enable_if_t<std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>>>
+	{
+		static bool Decode(const u8* data, size_t size, size_t& offset, BinType type, T& out)
+		{
+			if (type != BinType::String)
+				return BinParser::SkipValue(data, size, offset, type);
+
+			u16 length;
+			if (BinSchemaInternal::Read(data, size, offset, length) == false || offset + length > size)
+				return false;
+
+			out = T((const char*)data + offset, length);
+			offset += length;
+			return true;
+		}
+	};
+
+	// Float vectors read Vec2f, Vec3f and Vec4f of the same length, a vector of 4 also reads RGBA.
+	template<glm::length_t Length, typename T, glm::qualifier Q>
+	struct BinValueDecoder<glm::vec<Length, T, Q>>
+	{
+		static bool Decode(const u8* data, size_t size, size_t& offset, BinType type, glm::vec<Length, T, Q>& out)
+		{
+			constexpr BinType floatType = Length == 2 ? BinType::Vec2f : Length == 3 ? BinType::Vec3f : Length == 4 ? BinType::Vec4f : BinType::Empty;
+			if (type == floatType)
+				return DecodeElements<float>(data, size, offset, out);
+			if (type == BinType::RGBA && Length == 4)
+				return DecodeElements<u8>(data, size, offset, out);
+
+			return BinParser::SkipValue(data, size, offset, type);
+		}
+
+	private:
+		template<typename FileType>
+		static bool DecodeElements(const u8* data, size_t size, size_t& offset, glm::vec<Length, T, Q>& out)
+		{
+			for (glm::length_t i = 0; i < Length; i++)
+			{
+				FileType element;
+				if (BinSchemaInternal::Read(data, size, offset, element) == false)
+					return false;
+				out[i] = static_cast<T>(element);
+			}
+			return true;
+		}
+	};
+
+	template<>
+	struct BinValueDecoder<glm::mat4>
+	{
+		static bool Decode(const u8* data, size_t size, size_t& offset, BinType type, glm::mat4& out)
+		{
+			if (type != BinType::Mat4)
+				return BinParser::SkipValue(data, size, offset, type);
+
+			for (int x = 0; x < 4; x++)
+				for (int y = 0; y < 4; y++)
+					if (BinSchemaInternal::Read(data, size, offset, out[x][y]) == false)
+						return false;
+			return true;
+		}
+	};
+
+	// Reads Container, Container2 and Array.
+	template<typename T, typename Allocator>
+	struct BinValueDecoder<std::vector<T, Allocator>>
+	{
+		static bool Decode(const u8* data, size_t size, size_t& offset, BinType type, std::vector<T, Allocator>& out)
+		{
+			BinType elementType;
+			if (type == BinType::Array)
+			{
+				u8 count;
+				if (BinSchemaInternal::Read(data, size, offset, elementType) == false || BinSchemaInternal::Read(data, size, offset, count) == false)
+					return false;
+				return DecodeElements(data, size, offset, elementType, count, out);
+			}
+
+			if (type != BinType::Container && type != BinType::Container2)
+				return BinParser::SkipValue(data, size, offset, type);
+
+			u32 length;
+			if (BinSchemaInternal::Read(data, size, offset, elementType) == false || BinSchemaInternal::Read(data, size, offset, length) == false || offset + length > size)
+				return false;
+
+			size_t end = offset + length;
+			u32 count;
+			if (BinSchemaInternal::Read(data, end, offset, count) == false || DecodeElements(data, end, offset, elementType, count, out) == false)
+				return false;
+
+			offset = end;
+			return true;
+		}
+
+	private:
+		static bool DecodeElements(const u8* data, size_t size, size_t& offset, BinType elementType, u32 count, std::vector<T, Allocator>& out)
+		{
+			// Elements that are stored just like T are copied in one go.
+			if constexpr (std::is_trivially_copyable_v<T> && std::is_same_v<T, bool> == false)
+			{
+				if (IsNativeBinType<T>(elementType))
+				{
+					if (offset + sizeof(T) * count > size)
+						return false;
+
+					out.resize(count);
+					memcpy(out.data(), data + offset, sizeof(T) * count);
+					offset += sizeof(T) * count;
+					return true;
+				}
+			}
+
+			out.clear();
+			out.reserve(count);
+			for (u32 i = 0; i < count; i++)
+			{
+				// Decoded into a local, as std::vector<bool> has no references to its elements.
+				T element{};
+				if (DecodeBinValue(data, size, offset, elementType, element) == false)
+					return false;
+				out.push_back(std::move(element));
+			}
+			return true;
+		}
+	};
+
+	namespace BinSchemaInternal
+	{
+		template<typename Map>
+		bool DecodeMap(const u8* data, size_t size, size_t& offset, BinType type, Map& out)
+		{
+			if (type != BinType::Map)
+				return BinParser::SkipValue(data, size, offset, type);
+
+			BinType keyType;
+			BinType valueType;
+			u32 length;
+			if (Read(data, size, offset, keyType) == false || Read(data, size, offset, valueType) == false ||
+				Read(data, size, offset, length) == false || offset + length > size)
+				return false;
+
+			size_t end = offset + length;
+			u32 count;
+			if (Read(data, end, offset, count) == false)
+				return false;
+
+			out.clear();
+			for (u32 i = 0; i < count; i++)
+			{
+				typename Map::key_type key{};
+				typename Map::mapped_type value{};
+				if (DecodeBinValue(data, end, offset, keyType, key) == false || DecodeBinValue(data, end, offset, valueType, value) == false)
+					return false;
+
+				out.insert_or_assign(std::move(key), std::move(value));
+			}
+
+			offset = end;
+			return true;
+		}
+	}
+
+	template<typename Key, typename Value, typename... Rest>
+	struct BinValueDecoder<std::map<Key, Value, Rest...>>
+	{
+		static bool Decode(const u8* data, size_t size, size_t& offset, BinType type, std::map<Key, Value, Rest...>& out)
+		{
+			return BinSchemaInternal::DecodeMap(data, size, offset, type, out);
+		}
+	};
+
+	template<typename Key, typename Value, typename... Rest>
+	struct BinValueDecoder<std::unordered_map<Key, Value, Rest...>>
+	{
+		static bool Decode(const u8* data, size_t size, size_t& offset, BinType type, std::unordered_map<Key, Value, Rest...>& out)
+		{
+			return BinSchemaInternal::DecodeMap(data, size, offset, type, out);
+		}
+	};
+
+	namespace BinSchemaInternal
+	{
+		// Compiles down to a chain of hash compares, decoding into the member of the first binding that matches.
+		template<typename T, size_t... Indices>
+		bool DecodeField(const u8* data, size_t size, size_t& offset, u32 hash, BinType type, T& out, std::index_sequence<Indices...>)
+		{
+			constexpr auto& fields = BinBinding<T>::fields;
+
+			bool isValid = true;
+			bool isBound = ((std::get<Indices>(fields).hash == hash && (isValid = DecodeBinValue(data, size, offset, type, out.*(std::get<Indices>(fields).member)), true)) || ...);
+			if (isBound == false)
+				return BinParser::SkipValue(data, size, offset, type);
+			return isValid;
+		}
+
+		// Decodes count fields, which have to end before size.
+		template<typename T>
+		bool DecodeFields(const u8* data, size_t size, size_t& offset, u16 count, T& out)
+		{
+			using Indices = std::make_index_sequence<std::tuple_size_v<std::decay_t<decltype(BinBinding<T>::fields)>>>;
+			for (u16 i = 0; i < count; i++)
+			{
+				u32 hash;
+				BinType type;
+				if (Read(data, size, offset, hash) == false || Read(data, size, offset, type) == false)
+					return false;
+
+				if (DecodeField(data, size, offset, hash, type, out, Indices()) == false)
+					return false;
+			}
+
+			return true;
+		}
+	}
+
+	// Bound types read Struct and Embedded values. A null struct leaves the value untouched.
+	template<typename T>
+	struct BinValueDecoder<T, std::enable_if_t<HasBinBinding<T>>>
+	{
+		static bool Decode(const u8* data, size_t size, size_t& offset, BinType type, T& out)
+		{
+			if (type != BinType::Struct && type != BinType::Embedded)
+				return BinParser::SkipValue(data, size, offset, type);
+
+			u32 typeHash;
+			if (BinSchemaInternal::Read(data, size, offset, typeHash) == false)
+				return false;
+			if (typeHash == 0)
+				return true;
+
+			u32 length;
+			if (BinSchemaInternal::Read(data, size, offset, length) == false || offset + length > size)
+				return false;
+
+			size_t end = offset + length;
+			u16 count;
+			if (BinSchemaInternal::Read(data, end, offset, count) == false || BinSchemaInternal::DecodeFields(data, end, offset, count, out) == false)
+				return false;
+
+			offset = end;
+			return true;
+		}
+	};
+
+	// Decodes a root entry of a PROP file into out.
+	template<typename T>
+	bool DecodeBinEntry(const u8* data, size_t size, const Bin::Entry& entry, T& out)
+	{
+		static_assert(HasBinBinding<T>, "Root entries can only be decoded into types with a BinBinding.");
+
+		size_t end = entry.offset + entry.length;
+		size_t offset = entry.offset + sizeof(u32); // Skip the hash
+		u16 count;
+		if (end > size || BinSchemaInternal::Read(data, end, offset, count) == false)
+			return false;
+
+		return BinSchemaInternal::DecodeFields(data, end, offset, count, out);
+	}
+
+	// Decodes a root entry of a loaded bin into out, without parsing it into the bin.
+	template<typename T>
+	bool DecodeBinEntry(const Bin& bin, u32 hash, T& out)
+	{
+		const Bin::Entry* entry = bin.FindEntry(hash);
+		if (entry == nullptr || bin.GetLoadState() != Spek::File::LoadState::Loaded)
+			return false;
+
+		const std::vector<u8>& data = bin.GetFile()->GetData();
+		return DecodeBinEntry(data.data(), data.size(), *entry, out);
+	}
+
+	template<typename T>
+	bool DecodeBinEntry(const Bin& bin, BinFieldKey key, T& out)
+	{
+		return DecodeBinEntry(bin, key.hash, out);
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <league_lib/bin/bin.hpp>
+#include <league_lib/bin/bin_archive_files.hpp>
+#include <league_lib/wad/wad.hpp>
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace LeagueLib
+{
+	class WADFileSystem;
+	class WADHashDictionary;
+
+	// Names of the hashes in bins: entries, classes, fields and hash values all use the same hash, see HashName.
+	class BinNameTable
+	{
+	public:
+		void Add(std::string_view name);
+		void Add(u32 hash, std::string_view name);
+
+		// Adds every "<hex hash> <name>" line of a text file, like the hash lists of CDTB. Returns false if it can't be read.
+		bool AddTextList(const char* fileName);
+
+		bool Find(u32 hash, std::string_view& name) const;
+		size_t size() const { return m_names.size(); }
+
+	private:
+		std::unordered_map<u32, std::string> m_names;
+	};
+
+	// Converts PROP files to text, either as JSON or in the text format of ritobin.
+	// The text is written while the file is being parsed, so no BinVariables are created. Hashes that have a name in
+	// the name table are written as that name, and path hashes that are in the path dictionary as their path.
+	//
+	// JSON is written as { "version": 3, "linked": [...], "entries": { "<entry>": { "__class": "<class>", ... } } }.
+	// Structs are objects with their class in "__class", or null. Maps are objects with their keys as strings, unless
+	// the keys are structs, in which case they are arrays of [key, value] pairs.
+	class BinTextWriter
+	{
+	public:
+		enum class Format
+		{
+			Json,
+			Text
+		};
+
+		// Called from the default thread pool for every bin that was converted. The text is only valid during the call.
+		using OnFileFunction = std::function<void(const WAD& archive, WAD::FileNameHash fileHash, std::string_view text)>;
+
+		using FileFilterFunction = BinArchiveFiles::FileFilterFunction;
+
+		BinTextWriter(Format format = Format::Json) : m_format(format) {}
+
+		// The names and paths have to stay alive for as long as the writer is used.
+		BinTextWriter& SetNames(const BinNameTable* names);
+		BinTextWriter& SetPaths(const WADHashDictionary* paths);
+		BinTextWriter& SetFileFilter(FileFilterFunction filter);
+
+		Format GetFormat() const { return m_format; }
+
+		// Appends the text to output. Returns false if data isn't a valid PROP file, after writing as far as it got.
+		bool Write(const u8* data, size_t size, std::string& output) const;
+		bool Write(const Bin& bin, std::string& output) const;
+
+		// Writes the text to stream in blocks, without holding all of it in memory.
+		bool Write(const u8* data, size_t size, std::ostream& stream) const;
+
+		// Converts every bin of the archives in parallel, returning the number of bins that were converted.
+		// Files that are in more than one archive are taken from the first.
+		size_t Write(const std::vector<const WAD*>& archives, const OnFileFunction& onFile) const;
+		size_t Write(const WADFileSystem& fileSystem, const OnFileFunction& onFile) const;
+
+	private:
+		class Visitor;
+
+		bool Write(const u8* data, size_t size, std::string& output, std::ostream* stream) const;
+
+		Format m_format;
+		const BinNameTable* m_names = nullptr;
+		const WADHashDictionary* m_paths = nullptr;
+		FileFilterFunction m_fileFilter;
+	};
+}
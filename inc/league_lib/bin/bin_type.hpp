@@ -0,0 +1,114 @@
+#pragma once
+
+#include <spek/util/types.hpp>
+
+#include <glm/glm.hpp>
+#include <glm/ext/vector_uint4_sized.hpp>
+
+#include <cstddef>
+#include <type_traits>
+
+namespace LeagueLib
+{
+	// The type of a value, as stored in a PROP file.
+	enum class BinType : u8
+	{
+		Empty = 0,
+		Bool = 1,
+		S8 = 2,
+		U8 = 3,
+		S16 = 4,
+		U16 = 5,
+		S32 = 6,
+		U32 = 7,
+		S64 = 8,
+		U64 = 9,
+		Float = 10,
+		Vec2f = 11,
+		Vec3f = 12,
+		Vec4f = 13,
+		Mat4 = 14,
+		RGBA = 15,
+		String = 16,
+		Hash = 17,
+		Path = 18,
+		Container = 0x80,
+		Container2 = 0x81,
+		Struct = 0x82,
+		Embedded = 0x83,
+		Link = 0x84,
+		Array = 0x85,
+		Map = 0x86,
+		Flag = 0x87
+	};
+
+	// Size of a value of this type in the file, or 0 if its size depends on its contents.
+	constexpr size_t GetBinTypeSize(BinType type)
+	{
+		switch (type)
+		{
+		case BinType::Bool:
+		case BinType::S8:
+		case BinType::U8:
+		case BinType::Flag:
+			return 1;
+
+		case BinType::S16:
+		case BinType::U16:
+			return 2;
+
+		case BinType::S32:
+		case BinType::U32:
+		case BinType::Float:
+		case BinType::RGBA:
+		case BinType::Hash:
+		case BinType::Link:
+			return 4;
+
+		case BinType::S64:
+		case BinType::U64:
+		case BinType::Path:
+		case BinType::Vec2f:
+			return 8;
+
+		case BinType::Vec3f:	return 12;
+		case BinType::Vec4f:	return 16;
+		case BinType::Mat4:		return 64;
+
+		default:
+			return 0;
+		}
+	}
+
+	// Whether T has the same layout as a value of type in the file, so that values can be copied as they are.
+	// Bools and flags are bytes, colours are glm::u8vec4 and matrices are stored column by column like glm::mat4.
+	template<typename T>
+	constexpr bool IsNativeBinType(BinType type)
+	{
+		switch (type)
+		{
+		case BinType::Bool:
+		case BinType::Flag:
+		case BinType::U8:		return std::is_same_v<T, u8>;
+		case BinType::S8:		return std::is_same_v<T, i8>;
+		case BinType::S16:		return std::is_same_v<T, i16>;
+		case BinType::U16:		return std::is_same_v<T, u16>;
+		case BinType::S32:		return std::is_same_v<T, i32>;
+		case BinType::U32:
+		case BinType::Hash:
+		case BinType::Link:		return std::is_same_v<T, u32>;
+		case BinType::S64:		return std::is_same_v<T, i64>;
+		case BinType::U64:
+		case BinType::Path:		return std::is_same_v<T, u64>;
+		case BinType::Float:	return std::is_same_v<T, float>;
+		case BinType::Vec2f:	return std::is_same_v<T, glm::vec2>;
+		case BinType::Vec3f:	return std::is_same_v<T, glm::vec3>;
+		case BinType::Vec4f:	return std::is_same_v<T, glm::vec4>;
+		case BinType::RGBA:		return std::is_same_v<T, glm::u8vec4>;
+		case BinType::Mat4:		return std::is_same_v<T, glm::mat4>;
+
+		default:
+			return false;
+		}
+	}
+}
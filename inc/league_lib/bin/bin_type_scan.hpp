@@ -0,0 +1,60 @@
+#pragma once
+
+#include <league_lib/bin/bin.hpp>
+#include <league_lib/bin/bin_archive_files.hpp>
+#include <league_lib/wad/wad.hpp>
+
+#include <functional>
+#include <vector>
+
+namespace LeagueLib
+{
+	class WADFileSystem;
+
+	// Finds the root entries of some classes across many bins, such as every SpellObject in the game.
+	// The type array of every bin is used to pick out the entries, so nothing else in the file is parsed.
+	// A scan without any types matches every entry.
+	class BinTypeScan
+	{
+	public:
+		struct Match
+		{
+			const WAD* archive;				// nullptr when scanning data directly
+			WAD::FileNameHash fileHash;
+			Bin::Entry entry;
+			const u8* data;					// The whole file, only valid during the callback
+			size_t size;
+		};
+
+		// Called from the default thread pool, so it can be called from multiple threads at the same time.
+		// Use DecodeBinEntry or BinParser::ParseValue on the match to read the entry.
+		using OnMatchFunction = std::function<void(const Match& match)>;
+
+		using FileFilterFunction = BinArchiveFiles::FileFilterFunction;
+
+		BinTypeScan() = default;
+		BinTypeScan(std::initializer_list<u32> typeHashes);
+		BinTypeScan(std::initializer_list<BinFieldKey> typeKeys);
+
+		BinTypeScan& AddType(u32 typeHash);
+		BinTypeScan& AddType(BinFieldKey typeKey) { return AddType(typeKey.hash); }
+		BinTypeScan& SetFileFilter(FileFilterFunction filter);
+
+		bool HasType(u32 typeHash) const;
+
+		// Returns false if data isn't a PROP file.
+		bool Scan(const u8* data, size_t size, const OnMatchFunction& onMatch) const;
+
+		// Scans every file of the archives in parallel, returning the number of bins that were scanned.
+		// Files that are in more than one archive are only scanned in the first. Only files that start like a PROP file
+		// are extracted completely.
+		size_t Scan(const std::vector<const WAD*>& archives, const OnMatchFunction& onMatch) const;
+		size_t Scan(const WADFileSystem& fileSystem, const OnMatchFunction& onMatch) const;
+
+	private:
+		bool Scan(const WAD* archive, WAD::FileNameHash fileHash, const u8* data, size_t size, const OnMatchFunction& onMatch) const;
+
+		std::vector<u32> m_typeHashes; // Sorted
+		FileFilterFunction m_fileFilter;
+	};
+}
@@ -1,7 +1,15 @@
 #pragma once
 
+#include <atomic>
 #include <map>
+#include <memory_resource>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <new>
+#include <tuple>
 #include <variant>
 #include <algorithm>
 #include <vector>
@@ -9,6 +17,9 @@
 #include <glm/glm.hpp>
 #include <spek/util/types.hpp>
 
+#include <league_lib/bin/bin_type.hpp>
+#include <league_lib/util/hash.hpp>
+
 namespace LeagueLib
 {
 #define DECAY_TYPE(Variable) std::decay_t<decltype(Variable)>
@@ -22,27 +33,47 @@ namespace LeagueLib
 	// Compare functor for the map (so that we can use a BinVariable as a key
 	struct BinVariableCompare { bool operator() (const BinVariable& lhs, const BinVariable& rhs) const; };
 
-	using BinArray = std::vector<BinVariable>;
-	using BinMap = std::map<BinVariable, BinVariable, BinVariableCompare>;
+	// Containers use polymorphic allocators, so that a Bin can allocate its whole tree from its own arena.
+	// Copies made from those fall back to the default resource, so they can outlive the Bin.
+	// Strings are views into the Bin's file or arena however, they're only valid while the Bin is loaded. A BinVariable made
+	// from a BinString borrows it as well, but copying a BinVariable, or making one from a const char*, copies the characters.
+	using BinString = std::string_view;
+	using BinArray = std::pmr::vector<BinVariable>;
 
+	// The fields are stored as a vector sorted by hash. Inserting through the non-const operator[] keeps it sorted,
+	// but invalidates references to other fields, so prefer building the fields up front with SetVariables.
 	class BinObject
 	{
 	public:
-		using Map = std::map<u32, BinVariable>;
+		using Map = std::pmr::vector<std::pair<u32, BinVariable>>;
+
+		BinObject() = default;
+		explicit BinObject(std::pmr::memory_resource* resource) : m_variables(resource) {}
+
 		u32 GetTypeHash() const { return m_typeHash; }
 		void SetTypeHash(u32 typeHash) { m_typeHash = typeHash; }
 
+		// Takes the fields in any order and sorts them. If a hash occurs more than once, the last one is kept.
+		// This only takes over the storage if the fields use the same memory resource as this object.
+		void SetVariables(Map&& variables);
+		size_t size() const { return m_variables.size(); }
+		std::pmr::memory_resource* GetResource() const { return m_variables.get_allocator().resource(); }
+
 		const BinVariable& operator[](u32 hash) const;
 		const BinVariable& operator[](std::string_view name) const;
+		const BinVariable& operator[](BinFieldKey key) const;
 
 		BinVariable& operator[](u32 hash);
 		BinVariable& operator[](std::string_view name);
+		BinVariable& operator[](BinFieldKey key);
 
 		Map::const_iterator find(u32 hash) const;
 		Map::const_iterator find(std::string_view name) const;
+		Map::const_iterator find(BinFieldKey key) const;
 
 		Map::iterator find(u32 hash);
 		Map::iterator find(std::string_view name);
+		Map::iterator find(BinFieldKey key);
 
 		Map::const_iterator begin() const;
 		Map::const_iterator end() const;
@@ -51,12 +82,64 @@ namespace LeagueLib
 		Map::iterator end();
 
 	private:
-		u32 m_typeHash;
+		u32 m_typeHash = 0;
 		Map m_variables;
 	};
 
-	// All the possible entry types of a Bin element
-	using BinVariant = std::variant
+	// The pairs are stored as a vector sorted by key. Integer keys, which includes hashes and paths, are also kept in an
+	// array of their own, so looking them up is a binary search over plain integers. String keys are compared directly.
+	class BinMap
+	{
+	public:
+		using Pair = std::pair<BinVariable, BinVariable>;
+		using Storage = std::pmr::vector<Pair>;
+
+		BinMap() = default;
+		explicit BinMap(std::pmr::memory_resource* resource) : m_pairs(resource), m_integerKeys(resource) {}
+
+		// Takes the pairs in any order and sorts them. If a key occurs more than once, the last one is kept.
+		// This only takes over the storage if the pairs use the same memory resource as this map.
+		void SetPairs(Storage&& pairs);
+
+		// Keeps the pairs sorted, which makes building a map this way quadratic. Prefer SetPairs.
+		void insert_or_assign(BinVariable&& key, BinVariable&& value);
+
+		size_t size() const { return m_pairs.size(); }
+		bool empty() const { return m_pairs.empty(); }
+		std::pmr::memory_resource* GetResource() const { return m_pairs.get_allocator().resource(); }
+
+		// The BinTypeIndex of the keys, or 0 if the map is empty or the keys have different types.
+		u8 GetKeyTypeIndex() const { return m_keyType != MixedKeys ? m_keyType : 0; }
+
+		const BinVariable& operator[](const BinVariable& key) const;
+		const BinVariable& operator[](u64 key) const;
+		const BinVariable& operator[](std::string_view key) const;
+		const BinVariable& operator[](const char* key) const { return operator[](std::string_view(key)); }
+		const BinVariable& operator[](BinFieldKey key) const;
+
+		// Integers match keys of any integer type, negative values have to be passed as their two's complement.
+		// Field keys also match i32 keys with the same bits, as hashes are sometimes stored that way.
+		Storage::const_iterator find(const BinVariable& key) const;
+		Storage::const_iterator find(u64 key) const;
+		Storage::const_iterator find(std::string_view key) const;
+		Storage::const_iterator find(const char* key) const { return find(std::string_view(key)); }
+		Storage::const_iterator find(BinFieldKey key) const;
+
+		Storage::const_iterator begin() const { return m_pairs.begin(); }
+		Storage::const_iterator end() const { return m_pairs.end(); }
+
+	private:
+		static constexpr u8 MixedKeys = 0xFF;
+
+		void IndexKeys();
+
+		Storage m_pairs;
+		std::pmr::vector<u64> m_integerKeys; // Only filled if every key is an integer of the same type
+		u8 m_keyType = 0;
+	};
+
+	// All the possible entry types of a Bin element. BinVariable::GetTypeIndex() returns the index in this list.
+	using BinTypes = std::tuple
 	<
 		/*  0 */ std::monostate,
 		/*  1 */ i8,
@@ -68,7 +151,7 @@ namespace LeagueLib
 		/*  7 */ u32,
 		/*  8 */ u64,
 		/*  9 */ double,
-		/* 10 */ std::string,
+		/* 10 */ BinString,
 		/* 11 */ Colour,
 		/* 12 */ glm::vec2,
 		/* 13 */ glm::vec3,
@@ -82,26 +165,118 @@ namespace LeagueLib
 		/* 21 */ BinArray
 	>;
 
+	namespace BinTypeInternal
+	{
+		template<typename T, typename List> struct Contains;
+		template<typename T, typename... Types> struct Contains<T, std::tuple<Types...>> : std::disjunction<std::is_same<T, Types>...> {};
+
+		template<typename T, typename List> struct IndexOf;
+		template<typename T, typename... Types> struct IndexOf<T, std::tuple<T, Types...>> { static constexpr u8 value = 0; };
+		template<typename T, typename U, typename... Types> struct IndexOf<T, std::tuple<U, Types...>> { static constexpr u8 value = 1 + IndexOf<T, std::tuple<Types...>>::value; };
+	}
+
+	template<typename T> constexpr bool IsBinType = BinTypeInternal::Contains<T, BinTypes>::value;
+	template<typename T> constexpr u8 BinTypeIndex = BinTypeInternal::IndexOf<T, BinTypes>::value;
+	template<size_t Index> using BinTypeAt = std::tuple_element_t<Index, BinTypes>;
+
 	using BinVarRef = const BinVariable&;
 	using BinVarPtr = const BinVariable*;
 
-	// This is the variable, the variant with its overrides to ensure good access to any type of element.
-	class BinVariable : public BinVariant
+	// The elements of a typed array, see BinVariable::AsSpan.
+	template<typename T>
+	class BinSpan
 	{
 	public:
-		template<typename T>
-		BinVariable(const T& a) : BinVariant(a) {}
-		BinVariable() : BinVariant(std::in_place_type<std::monostate>) {}
+		BinSpan() = default;
+		BinSpan(const T* data, size_t size) : m_data(data), m_size(size) {}
+
+		const T* data() const { return m_data; }
+		size_t size() const { return m_size; }
+		bool empty() const { return m_size == 0; }
+
+		const T* begin() const { return m_data; }
+		const T* end() const { return m_data + m_size; }
+		const T& operator[](size_t index) const { return m_data[index]; }
+
+	private:
+		const T* m_data = nullptr;
+		size_t m_size = 0;
+	};
+
+	// Parses values that were skipped when their parent was parsed, see BinVariable::MakeLazy.
+	class BinLazySource
+	{
+	public:
+		virtual ~BinLazySource() = default;
+
+	protected:
+		friend class BinVariable;
+
+		// Called once per lazy node, with m_mutex locked.
+		virtual BinVariable Parse(size_t offset, u8 fileType) const = 0;
+
+		mutable std::mutex m_mutex;
+	};
+
+	// This is the variable, a tagged union with overrides to ensure good access to any type of element.
+	// Scalars, strings and vectors are stored inline. Matrices and containers live in a separate block, allocated from
+	// the same memory resource as their contents, which keeps every node at 24 bytes.
+	class BinVariable
+	{
+	public:
+		BinVariable() : m_type(0) {}
+
+		template<typename T, typename = std::enable_if_t<IsBinType<std::decay_t<T>>>>
+		BinVariable(T&& value) : m_type(0)
+		{
+			// Copies go to the default resource, just like copying the containers themselves.
+			Construct(std::forward<T>(value), std::is_lvalue_reference_v<T> ? std::pmr::get_default_resource() : GetResource(value));
+		}
+
+		// Allocates the block of a matrix or container from resource.
+		template<typename T, typename = std::enable_if_t<IsBinType<std::decay_t<T>>>>
+		BinVariable(T&& value, std::pmr::memory_resource* resource) : m_type(0)
+		{
+			Construct(std::forward<T>(value), resource);
+		}
+
+		// These used to be picked by std::variant's conversion rules, so they end up in the same types.
+		BinVariable(bool value) : BinVariable((i32)value) {}
+		BinVariable(float value) : BinVariable((double)value) {}
+		BinVariable(const char* value) : BinVariable(MakeOwnedString(value, std::pmr::get_default_resource())) {}
+
+		BinVariable(const BinVariable& other);
+		BinVariable(BinVariable&& other) noexcept;
+		~BinVariable() { Destroy(); }
+
+		BinVariable& operator=(const BinVariable& other);
+		BinVariable& operator=(BinVariable&& other) noexcept;
+
+		// Creates a node that is only parsed by source once it's accessed. typeIndex is the type it will resolve to.
+		static BinVariable MakeLazy(const BinLazySource& source, size_t offset, u8 fileType, u8 typeIndex, std::pmr::memory_resource* resource);
+
+		// Creates an array of count fixed-size values of elementType, copied from data as they are in the file.
+		// It acts like a BinArray, but its BinVariables are only created when it's accessed as one.
+		static BinVariable MakeTypedArray(BinType elementType, const void* data, u32 count, std::pmr::memory_resource* resource);
 
 		const BinVariable& operator[](size_t index) const;
 		const BinVariable& operator[](std::string_view name) const;
+		const BinVariable& operator[](BinFieldKey key) const;
 
 		bool IsValid() const;
+		size_t GetTypeIndex() const;
 
 		template<typename T>
 		const T* As() const
 		{
-			return std::get_if<T>(this);
+			if (m_type == LazyType || m_type == TypedArrayType)
+				return Resolve().As<T>();
+
+			static_assert(IsBinType<T>, "T is not a BinTypes member");
+			if constexpr (std::is_same_v<T, BinString>)
+				if (m_type == OwnedStringType)
+					return &static_cast<const Block<BinString>*>(m_block)->value;
+			return m_type == BinTypeIndex<T> ? GetPointer<T>() : nullptr;
 		}
 
 		template<typename T>
@@ -109,5 +284,109 @@ namespace LeagueLib
 		{
 			return !!As<T>();
 		}
+
+		// The elements of a typed array, without a BinVariable per element. T has to match the element type in the
+		// file (see IsNativeBinType), like float for Float or u32 for Hash. Empty if this isn't a typed array of T.
+		template<typename T>
+		BinSpan<T> AsSpan() const
+		{
+			BinType elementType;
+			u32 count;
+			const void* data = GetTypedArray(elementType, count);
+			if (data == nullptr || IsNativeBinType<T>(elementType) == false)
+				return BinSpan<T>();
+			return BinSpan<T>(static_cast<const T*>(data), count);
+		}
+
+		// Calls function with the value as its actual type, like std::visit.
+		template<typename Function>
+		decltype(auto) Visit(Function&& function) const
+		{
+			switch (m_type)
+			{
+#define BIN_VISIT_CASE(Index) case Index: return function(*GetPointer<BinTypeAt<Index>>());
+			BIN_VISIT_CASE(1)	BIN_VISIT_CASE(2)	BIN_VISIT_CASE(3)	BIN_VISIT_CASE(4)	BIN_VISIT_CASE(5)
+			BIN_VISIT_CASE(6)	BIN_VISIT_CASE(7)	BIN_VISIT_CASE(8)	BIN_VISIT_CASE(9)	BIN_VISIT_CASE(10)
+			BIN_VISIT_CASE(11)	BIN_VISIT_CASE(12)	BIN_VISIT_CASE(13)	BIN_VISIT_CASE(14)	BIN_VISIT_CASE(15)
+			BIN_VISIT_CASE(16)	BIN_VISIT_CASE(17)	BIN_VISIT_CASE(18)	BIN_VISIT_CASE(19)	BIN_VISIT_CASE(20)
+			BIN_VISIT_CASE(21)
+#undef BIN_VISIT_CASE
+			case LazyType:
+			case TypedArrayType: return Resolve().Visit(std::forward<Function>(function));
+			case OwnedStringType: return function(static_cast<const Block<BinString>*>(m_block)->value);
+			default: return function(*GetPointer<std::monostate>());
+			}
+		}
+
+	private:
+		// Internal type of nodes that haven't been parsed yet, these resolve to one of the BinTypes on access.
+		static constexpr u8 LazyType = std::tuple_size_v<BinTypes>;
+		struct LazyValue;
+
+		// Internal type of typed arrays, these act as a BinArray that is created on access.
+		static constexpr u8 TypedArrayType = LazyType + 1;
+		struct TypedArray;
+
+		// Internal type of strings that were copied, these own their characters, which are stored right after the block.
+		static constexpr u8 OwnedStringType = TypedArrayType + 1;
+		static BinVariable MakeOwnedString(BinString value, std::pmr::memory_resource* resource);
+
+		template<typename T>
+		static constexpr bool IsInline = sizeof(T) <= 16 && alignof(T) <= 8 && std::is_trivially_copyable_v<T>;
+
+		template<typename T>
+		struct Block
+		{
+			std::pmr::memory_resource* resource;
+			T value;
+		};
+
+		template<typename T>
+		static std::pmr::memory_resource* GetResource(const T& value)
+		{
+			if constexpr (std::is_same_v<std::decay_t<T>, BinObject> || std::is_same_v<std::decay_t<T>, BinMap>)
+				return value.GetResource();
+			else if constexpr (std::is_same_v<std::decay_t<T>, BinArray>)
+				return value.get_allocator().resource();
+			else
+				return std::pmr::get_default_resource();
+		}
+
+		template<typename T>
+		const T* GetPointer() const
+		{
+			if constexpr (IsInline<T>)
+				return reinterpret_cast<const T*>(m_data);
+			else
+				return &static_cast<const Block<T>*>(m_block)->value;
+		}
+
+		template<typename U>
+		void Construct(U&& value, std::pmr::memory_resource* resource)
+		{
+			using T = std::decay_t<U>;
+			if constexpr (IsInline<T>)
+			{
+				new (m_data) T(std::forward<U>(value));
+			}
+			else
+			{
+				void* memory = resource->allocate(sizeof(Block<T>), alignof(Block<T>));
+				m_block = new (memory) Block<T>{ resource, std::forward<U>(value) };
+			}
+			m_type = BinTypeIndex<T>;
+		}
+
+		// Returns the parsed value of a lazy node, or the BinArray of a typed array.
+		const BinVariable& Resolve() const;
+		const void* GetTypedArray(BinType& elementType, u32& count) const;
+		void Destroy();
+
+		union
+		{
+			alignas(8) u8 m_data[16];
+			void* m_block;
+		};
+		u8 m_type;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <league_lib/bin/bin.hpp>
+#include <league_lib/bin/bin_parser.hpp>
+#include <league_lib/bin/bin_type.hpp>
+
+#include <cassert>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace LeagueLib
+{
+	// Writes PROP files (version 3). The length prefixes, counts and the type array are filled in as the entries are
+	// written, so values are written one after the other, and structs, containers and maps are begun and ended.
+	//
+	// The writer is a BinVisitor as well, so BinParser::Parse(data, size, writer) copies a file into it, which lets a
+	// visitor in between change or drop parts of a file.
+	//
+	// Parsed values lose some of their type: hashes, links and paths are integers, flags are bools, and pointers and
+	// embedded structs are both BinObjects. WriteEntry and WriteVariable look up the actual types of fields in the types
+	// learned with AddTypes, and fall back to U32, U64, Bool, Embedded and Container for anything that isn't known.
+	class BinWriter : public BinVisitor
+	{
+	public:
+		BinWriter() = default;
+
+		// Learns the type of every field of every class in a PROP file. Returns false if data isn't one.
+		bool AddTypes(const u8* data, size_t size);
+
+		void AddLinkedFile(std::string_view name);
+
+		void BeginEntry(u32 hash, u32 typeHash);
+		void EndEntry();
+
+		// Fields are written to the entry or struct that was begun last, followed by their value.
+		void WriteField(u32 hash, BinType type);
+
+		// T has to match the type, see IsNativeBinType.
+		template<typename T>
+		void WriteValue(BinType type, const T& value)
+		{
+			assert(IsNativeBinType<T>(type));
+			WriteValue({ type, reinterpret_cast<const u8*>(&value), sizeof(T) });
+		}
+		void WriteValue(const BinValueView& value);
+		void WriteString(std::string_view value);
+
+		// A typeHash of 0 writes a null struct, which has no fields.
+		void BeginStruct(u32 typeHash);
+		void EndStruct();
+
+		// type is either Container, Container2 or Array. Arrays hold at most one element.
+		void BeginContainer(BinType type, BinType elementType);
+		void EndContainer();
+
+		// Keys and values are written in turns.
+		void BeginMap(BinType keyType, BinType valueType);
+		void EndMap();
+
+		// Writes a parsed entry or value, see the types above. Values that have no type in the file are left out.
+		void WriteEntry(u32 hash, const BinObject& object);
+		bool WriteVariable(BinType type, const BinVariable& value);
+
+		// Puts the finished file in output and clears the writer, apart from the learned types.
+		void Finish(std::vector<u8>& output);
+		bool Save(const std::string& path);
+
+		// Writes the parsed entries of a loaded bin, with the types of its own file.
+		static bool Write(const Bin& bin, std::vector<u8>& output);
+
+		Action OnLinkedFile(std::string_view name) override;
+		Action OnBeginEntry(u32 hash, u32 typeHash) override;
+		Action OnEndEntry(u32 hash) override;
+		Action OnField(u32 hash, BinType type) override;
+		Action OnValue(const BinValueView& value) override;
+		Action OnBeginStruct(u32 typeHash) override;
+		Action OnEndStruct() override;
+		Action OnBeginContainer(BinType type, BinType elementType, u32 count) override;
+		Action OnEndContainer() override;
+		Action OnBeginMap(BinType keyType, BinType valueType, u32 count) override;
+		Action OnEndMap() override;
+
+	private:
+		// The type of a field, with the element types of containers and the key and value types of maps.
+		struct FieldType
+		{
+			BinType type = BinType::Empty;
+			BinType elementType = BinType::Empty; // Element type of containers, key type of maps
+			BinType valueType = BinType::Empty;
+			BinType valueElementType = BinType::Empty; // Maps of containers
+		};
+
+		struct Frame
+		{
+			enum class Kind : u8
+			{
+				Fields,
+				Container,
+				Array,
+				Map,
+				Null
+			};
+
+			Kind kind;
+			size_t lengthOffset; // Not used by arrays and null structs
+			size_t countOffset;
+			u32 count = 0;
+			bool isKey = true;
+		};
+
+		class TypeCollector;
+
+		const FieldType* FindFieldType(u32 typeHash, u32 fieldHash) const;
+		bool WriteVariable(const FieldType& type, const BinVariable& value);
+		void WriteFields(const BinObject& object);
+		bool WriteTypedArray(BinType elementType, const BinVariable& value);
+		void CountValue();
+		void EndFrame();
+
+		template<typename T>
+		void Append(const T& value)
+		{
+			Append(&value, sizeof(T));
+		}
+		void Append(const void* data, size_t size);
+
+		std::vector<std::string> m_linkedFiles;
+		std::vector<u32> m_typeArray;
+		std::vector<u8> m_data; // The entries
+		std::vector<Frame> m_frames;
+
+		std::unordered_map<u32, std::unordered_map<u32, FieldType>> m_classes;
+	};
+}
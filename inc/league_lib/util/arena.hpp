@@ -0,0 +1,50 @@
+#pragma once
+
+#include <spek/util/types.hpp>
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace LeagueLib
+{
+	// Monotonic allocator: allocations are bumped out of large blocks and only freed all at once by Release().
+	// Not thread-safe, use one arena per thread.
+	class Arena : public std::pmr::memory_resource
+	{
+	public:
+		Arena() : Arena(64 * 1024) {}
+		explicit Arena(size_t inBlockSize);
+		Arena(const Arena&) = delete;
+		~Arena();
+
+		Arena& operator=(const Arena&) = delete;
+
+		// Frees everything that was allocated. The most recent block is kept around for reuse.
+		void Release();
+
+		size_t GetUsedBytes() const { return m_usedBytes; }
+		size_t GetReservedBytes() const { return m_reservedBytes; }
+
+	protected:
+		void* do_allocate(size_t inBytes, size_t inAlignment) override;
+		void do_deallocate(void*, size_t, size_t) override {}
+		bool do_is_equal(const std::pmr::memory_resource& inOther) const noexcept override { return this == &inOther; }
+
+	private:
+		struct Block
+		{
+			Block* next;
+			size_t size;
+		};
+
+		void AddBlock(size_t inMinimumSize);
+
+		Block* m_blocks = nullptr;
+		u8* m_current = nullptr;
+		u8* m_end = nullptr;
+
+		size_t m_blockSize;
+		size_t m_usedBytes = 0;
+		size_t m_reservedBytes = 0;
+	};
+}
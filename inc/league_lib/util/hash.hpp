@@ -0,0 +1,152 @@
+#pragma once
+
+#include <spek/util/types.hpp>
+
+#include <cstddef>
+#include <string_view>
+
+namespace LeagueLib
+{
+	// Lowercase XXH64, used for the path hashes in WAD archives.
+	u64 HashPath(std::string_view inPath);
+
+	// XXH64 with seed 0 over data as it is, for checksums of file contents.
+	u64 HashData(const void* inData, size_t inSize);
+
+	// Lowercase FNV-1a, used for the entry, type and field name hashes in Bin files.
+	u32 HashName(std::string_view inName);
+
+	// Batch versions of the above, writing one hash per input to outHashes.
+	void HashPaths(const std::string_view* inPaths, size_t inCount, u64* outHashes);
+	void HashNames(const std::string_view* inNames, size_t inCount, u32* outHashes);
+
+	// Constant expression versions of HashPath and HashName. These produce the same hashes, but are slower at runtime.
+	namespace HashInternal
+	{
+		constexpr u64 XXH64Prime1 = 11400714785074694791ULL;
+		constexpr u64 XXH64Prime2 = 14029467366897019727ULL;
+		constexpr u64 XXH64Prime3 = 1609587929392839161ULL;
+		constexpr u64 XXH64Prime4 = 9650029242287828579ULL;
+		constexpr u64 XXH64Prime5 = 2870177450012600261ULL;
+
+		constexpr u8 ToLower(char inChar)
+		{
+			return (inChar >= 'A' && inChar <= 'Z') ? (u8)(inChar + ('a' - 'A')) : (u8)inChar;
+		}
+
+		constexpr u64 ReadLower(std::string_view inString, size_t inOffset, size_t inBytes)
+		{
+			u64 result = 0;
+			for (size_t i = 0; i < inBytes; i++)
+				result |= (u64)ToLower(inString[inOffset + i]) << (i * 8);
+			return result;
+		}
+
+		constexpr u64 RotateLeft(u64 inValue, int inBits)
+		{
+			return (inValue << inBits) | (inValue >> (64 - inBits));
+		}
+
+		constexpr u64 XXH64Round(u64 inAccumulator, u64 inInput)
+		{
+			return RotateLeft(inAccumulator + inInput * XXH64Prime2, 31) * XXH64Prime1;
+		}
+
+		constexpr u64 XXH64Merge(u64 inAccumulator, u64 inValue)
+		{
+			return (inAccumulator ^ XXH64Round(0, inValue)) * XXH64Prime1 + XXH64Prime4;
+		}
+
+		constexpr u64 XXH64(std::string_view inString)
+		{
+			size_t length = inString.size();
+			size_t offset = 0;
+
+			u64 hash = XXH64Prime5;
+			if (length >= 32)
+			{
+				u64 lane1 = XXH64Prime1 + XXH64Prime2;
+				u64 lane2 = XXH64Prime2;
+				u64 lane3 = 0;
+				u64 lane4 = 0 - XXH64Prime1;
+				for (; offset + 32 <= length; offset += 32)
+				{
+					lane1 = XXH64Round(lane1, ReadLower(inString, offset, 8));
+					lane2 = XXH64Round(lane2, ReadLower(inString, offset + 8, 8));
+					lane3 = XXH64Round(lane3, ReadLower(inString, offset + 16, 8));
+					lane4 = XXH64Round(lane4, ReadLower(inString, offset + 24, 8));
+				}
+
+				hash = RotateLeft(lane1, 1) + RotateLeft(lane2, 7) + RotateLeft(lane3, 12) + RotateLeft(lane4, 18);
+				hash = XXH64Merge(hash, lane1);
+				hash = XXH64Merge(hash, lane2);
+				hash = XXH64Merge(hash, lane3);
+				hash = XXH64Merge(hash, lane4);
+			}
+
+			hash += length;
+			for (; offset + 8 <= length; offset += 8)
+				hash = RotateLeft(hash ^ XXH64Round(0, ReadLower(inString, offset, 8)), 27) * XXH64Prime1 + XXH64Prime4;
+
+			if (offset + 4 <= length)
+			{
+				hash = RotateLeft(hash ^ (ReadLower(inString, offset, 4) * XXH64Prime1), 23) * XXH64Prime2 + XXH64Prime3;
+				offset += 4;
+			}
+
+			for (; offset < length; offset++)
+				hash = RotateLeft(hash ^ (ToLower(inString[offset]) * XXH64Prime5), 11) * XXH64Prime1;
+
+			hash ^= hash >> 33;
+			hash *= XXH64Prime2;
+			hash ^= hash >> 29;
+			hash *= XXH64Prime3;
+			hash ^= hash >> 32;
+			return hash;
+		}
+
+		constexpr u32 FNV(std::string_view inString)
+		{
+			u32 hash = 0x811c9dc5;
+			for (char c : inString)
+				hash = (hash ^ ToLower(c)) * 0x01000193;
+			return hash;
+		}
+	}
+
+	// Key for the name lookups in Bin files (root entries and object fields).
+	// Use the _field literal in a constant expression to have the name hashed at compile time:
+	//     static constexpr BinFieldKey spellKey = "mSpell"_field;
+	struct BinFieldKey
+	{
+		constexpr explicit BinFieldKey(u32 inHash) : hash(inHash) {}
+		constexpr explicit BinFieldKey(std::string_view inName) : hash(HashInternal::FNV(inName)) {}
+
+		constexpr bool operator==(const BinFieldKey& inOther) const { return hash == inOther.hash; }
+		constexpr bool operator!=(const BinFieldKey& inOther) const { return hash != inOther.hash; }
+
+		u32 hash;
+	};
+
+	// Key for the path lookups in WAD archives, made with the _path literal.
+	struct WADPathKey
+	{
+		constexpr explicit WADPathKey(u64 inHash) : hash(inHash) {}
+		constexpr explicit WADPathKey(std::string_view inPath) : hash(HashInternal::XXH64(inPath)) {}
+
+		constexpr bool operator==(const WADPathKey& inOther) const { return hash == inOther.hash; }
+		constexpr bool operator!=(const WADPathKey& inOther) const { return hash != inOther.hash; }
+
+		u64 hash;
+	};
+
+	constexpr BinFieldKey operator"" _field(const char* inName, size_t inLength)
+	{
+		return BinFieldKey(std::string_view(inName, inLength));
+	}
+
+	constexpr WADPathKey operator"" _path(const char* inPath, size_t inLength)
+	{
+		return WADPathKey(std::string_view(inPath, inLength));
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <spek/util/types.hpp>
+
+#include <cstddef>
+
+namespace LeagueLib
+{
+	// Read-only memory mapping of a file on disk. The mapping stays valid until Close() or destruction.
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile&& inOther) noexcept;
+		~MappedFile();
+
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile& operator=(MappedFile&& inOther) noexcept;
+
+		bool Open(const char* inFileName);
+		void Close();
+
+		bool IsOpen() const { return m_data != nullptr; }
+		const u8* GetData() const { return m_data; }
+		size_t GetSize() const { return m_size; }
+
+	private:
+		const u8* m_data = nullptr;
+		size_t m_size = 0;
+
+#if defined(_WIN32)
+		void* m_fileHandle = nullptr;
+		void* m_mappingHandle = nullptr;
+#endif
+	};
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <league_lib/util/arena.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_set>
+
+namespace LeagueLib
+{
+	// Keeps one copy of every string that is added, so that equal strings share their memory.
+	// The strings are split over shards by hash, each with a lock of its own. Strings that are already in the pool are
+	// found under a shared lock, so any number of threads can intern at once.
+	class StringPool
+	{
+	public:
+		struct Stats
+		{
+			size_t stringCount;		// Unique strings in the pool
+			size_t stringBytes;		// Their combined length
+			size_t reservedBytes;	// Memory reserved for them
+			size_t internCount;		// Calls to Intern
+			size_t savedBytes;		// Bytes of the strings that were already in the pool
+		};
+
+		StringPool() = default;
+		StringPool(const StringPool&) = delete;
+		StringPool& operator=(const StringPool&) = delete;
+
+		// Shared by every Bin that is loaded with Bin::InternStrings.
+		static StringPool& GetDefault();
+
+		// Returns the pool's copy of inString, which stays valid until the pool is cleared.
+		std::string_view Intern(std::string_view inString);
+
+		Stats GetStats() const;
+
+		// Frees every string. Only call this when none of them are in use anymore.
+		void Clear();
+
+	private:
+		struct Key
+		{
+			u64 hash;
+			std::string_view string;
+
+			bool operator==(const Key& inOther) const { return hash == inOther.hash && string == inOther.string; }
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const Key& inKey) const { return (size_t)inKey.hash; }
+		};
+
+		struct Shard
+		{
+			mutable std::shared_mutex mutex;
+			std::unordered_set<Key, KeyHash> strings;
+			Arena arena;
+			size_t stringBytes = 0;
+
+			std::atomic<size_t> internCount = 0;
+			std::atomic<size_t> savedBytes = 0;
+		};
+
+		static constexpr size_t ShardCount = 32;
+		std::array<Shard, ShardCount> m_shards;
+	};
+}
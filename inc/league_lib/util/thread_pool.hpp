@@ -0,0 +1,42 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace LeagueLib
+{
+	class ThreadPool
+	{
+	public:
+		using Task = std::function<void()>;
+		using RangeFunction = std::function<void(size_t inBegin, size_t inEnd)>;
+
+		// A thread count of 0 uses one thread per hardware thread.
+		ThreadPool(size_t inThreadCount = 0);
+		~ThreadPool();
+
+		static ThreadPool& GetDefault();
+
+		size_t GetThreadCount() const { return m_threads.size(); }
+		void Submit(Task inTask);
+
+		// Splits [0, inCount) into ranges of inGrainSize and runs them on the pool, returning once all of them are done.
+		// The calling thread works on ranges as well, so this is safe to call from within a task.
+		// The first exception thrown by inFunction is rethrown here.
+		void ParallelFor(size_t inCount, size_t inGrainSize, const RangeFunction& inFunction);
+
+	private:
+		void WorkerLoop();
+
+		std::vector<std::thread> m_threads;
+		std::deque<Task> m_tasks;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_isStopping = false;
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <spek/file/file.hpp>
+#include <league_lib/util/hash.hpp>
 
 #include <unordered_map>
 #include <vector>
@@ -45,6 +46,7 @@ namespace LeagueLib
 			uint32_t fileSize;
 			uint8_t  typeData;
 			uint16_t firstSubchunkIndex;
+			uint64_t checksum;
 		};
 
 		using FileDataMap = std::unordered_map<FileNameHash, MinFileData>;
@@ -56,12 +58,23 @@ namespace LeagueLib
 
 		bool   HasFile(uint64_t inFileHash) const;
 		bool   HasFile(const char* inFileName) const;
+		bool   HasFile(WADPathKey inKey) const { return HasFile(inKey.hash); }
 		bool   ExtractFile(std::string_view inFileName, std::vector<u8>& inOutput) const;
 		bool   ExtractFile(uint64_t inFileName, std::vector<u8>& inResult) const;
+		bool   ExtractFile(WADPathKey inKey, std::vector<u8>& inResult) const { return ExtractFile(inKey.hash, inResult); }
 		bool   ExtractFile(std::string_view inFileName, u8* inResult) const;
 		bool   ExtractFile(uint64_t inHash, u8* inResult) const;
+		bool   ExtractFile(WADPathKey inKey, u8* inResult) const { return ExtractFile(inKey.hash, inResult); }
+
+		// Extracts only the first inSize bytes of a file, decompressing no more than needed to get them. This is meant to
+		// check what kind of file it is without extracting all of it. Returns false if the file is shorter than inSize.
+		bool   ExtractFileStart(uint64_t inHash, u8* inResult, size_t inSize) const;
 		size_t GetFileSize(std::string_view inFileName) const;
 		size_t GetFileSize(uint64_t inFileName) const;
+		size_t GetFileSize(WADPathKey inKey) const { return GetFileSize(inKey.hash); }
+
+		// Checksum of the file's data as it is stored in the archive, 0 if the archive doesn't have the file.
+		uint64_t GetFileChecksum(uint64_t inFileHash) const;
 
 		Spek::File::LoadState GetLoadState() const;
 
@@ -69,6 +82,7 @@ namespace LeagueLib
 		FileDataMap::const_iterator end() const { return m_fileData.end(); }
 
 		std::string GetFileName() const { return m_fileName; }
+		uint64_t GetChecksum() const { return m_checksum; }
 
 	private:
 		std::vector<u8> m_subchunkStream;
@@ -77,6 +91,7 @@ namespace LeagueLib
 		Spek::File::LoadState m_loadState = Spek::File::LoadState::NotLoaded;
 
 		struct { char major = 0, minor = 0; } m_version;
+		uint64_t m_checksum = 0;
 		bool m_isParsed = false;
 	};
 }
\ No newline at end of file
@@ -20,6 +20,8 @@ namespace LeagueLib
 
 		void Update() override;
 
+		const std::vector<std::unique_ptr<WAD>>& GetArchives() const { return m_archives; }
+
 	protected:
 		Spek::File::Handle Get(const char* inLocation, u32 inLoadFlags) override;
 		Spek::File::Handle GetInternal(const char* inLocation, bool inInvalidate);
@@ -34,6 +36,7 @@ namespace LeagueLib
 			WAD* Archive;
 			Spek::File::Handle File;
 			std::string Name;
+			uint64_t Hash;
 		};
 
 		std::vector<std::string> m_entries;
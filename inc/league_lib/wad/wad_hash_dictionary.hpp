@@ -0,0 +1,71 @@
+#pragma once
+
+#include <league_lib/wad/wad.hpp>
+#include <league_lib/util/mapped_file.hpp>
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LeagueLib
+{
+	// Reverse lookup of WAD path hashes. The dictionary is a single flat file with the hashes sorted
+	// for binary search, and the names front-coded in blocks, so it can be memory mapped as-is.
+	class WADHashDictionary
+	{
+	public:
+		using FileNameHash = WAD::FileNameHash;
+		using OnResolveFunction = std::function<void(FileNameHash inHash, std::string_view inFileName, const WAD::MinFileData& inFileData)>;
+
+		bool Load(const char* inFileName);
+		bool Load(std::vector<u8>&& inData);
+		void Unload();
+
+		bool IsLoaded() const { return m_data != nullptr; }
+		size_t GetCount() const { return m_count; }
+
+		bool Has(FileNameHash inHash) const;
+		bool Has(WADPathKey inKey) const { return Has(inKey.hash); }
+		bool Find(FileNameHash inHash, std::string& outFileName) const;
+		bool Find(WADPathKey inKey, std::string& outFileName) const { return Find(inKey.hash, outFileName); }
+
+		// Calls inOnResolve for every file in the archive, with an empty name if the hash is unknown.
+		// The archive hashes are visited in sorted order, so that each block is decoded at most once.
+		void Resolve(const WAD& inArchive, OnResolveFunction inOnResolve) const;
+
+	private:
+		bool Validate();
+		size_t FindIndex(FileNameHash inHash) const;
+		bool DecodeName(size_t inIndex, std::string& outFileName) const;
+
+		MappedFile m_mappedFile;
+		std::vector<u8> m_ownedData;
+
+		const u8* m_data = nullptr;
+		size_t m_size = 0;
+
+		const FileNameHash* m_hashes = nullptr;
+		const u32* m_blockOffsets = nullptr;
+		const u8* m_strings = nullptr;
+		size_t m_stringSize = 0;
+		size_t m_count = 0;
+		u32 m_blockSize = 0;
+	};
+
+	class WADHashDictionaryBuilder
+	{
+	public:
+		void Add(WAD::FileNameHash inHash, std::string_view inFileName);
+		void Add(std::string_view inFileName);
+
+		// Adds every "<hex hash> <path>" line of a hash list text file.
+		bool AddTextList(const char* inFileName);
+
+		std::vector<u8> Build(u32 inBlockSize = 16) const;
+		bool Write(const char* inFileName, u32 inBlockSize = 16) const;
+
+	private:
+		std::vector<std::pair<WAD::FileNameHash, std::string>> m_entries;
+	};
+}
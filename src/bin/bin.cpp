@@ -1,10 +1,15 @@
 #include "league_lib/bin/bin.hpp"
 #include "league_lib/bin/bin_valuestorage.hpp"
+#include "league_lib/bin/bin_type.hpp"
+#include "league_lib/util/hash.hpp"
+#include "league_lib/util/thread_pool.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <fstream>
+#include <thread>
 
-#define BIN_FAST_FIND 1
 #define BIN_USE_CACHE 1
 
 // TODO: Improve this?
@@ -40,245 +45,515 @@ namespace LeagueLib
 {
 	using namespace Spek;
 
-	enum class Type : u8
-	{
-		Empty = 0,
-		Bool = 1,
-		S8 = 2,
-		U8 = 3,
-		S16 = 4,
-		U16 = 5,
-		S32 = 6,
-		U32 = 7,
-		S64 = 8,
-		U64 = 9,
-		Float = 10,
-		Vec2f = 11,
-		Vec3f = 12,
-		Vec4f = 13,
-		Mat4 = 14,
-		RGBA = 15,
-		String = 16,
-		Hash = 17,
-		Path = 18,
-		Container = 0x80,
-		Container2 = 0x81,
-		Struct = 0x82,
-		Embedded = 0x83,
-		Link = 0x84,
-		Array = 0x85,
-		Map = 0x86,
-		Flag = 0x87
-	};
-
-	u32 FNV1Hash(const std::string& inString);
-	BinVariable ConstructType(const File::Handle file, size_t& offset, Type type);
+	using Type = BinType;
 
-	Bin::~Bin()
+	template<typename T>
+	static bool ReadRaw(const u8* data, size_t size, size_t& offset, T& value)
 	{
+		if (offset + sizeof(T) > size)
+			return false;
+
+		memcpy(&value, data + offset, sizeof(T));
+		offset += sizeof(T);
+		return true;
 	}
 
-	void Bin::Load(const std::string& filePath, OnLoadFunction onLoadFunction)
+	// The data of a file that values are parsed from. This is either the file's own data, or a copy of it that
+	// outlives a reload, which overwrites the file's data in place.
+	class FileView
 	{
-		m_file = File::Load(filePath.c_str(), [this, onLoadFunction](File::Handle file, File::LoadState inLoadState)
+	public:
+		FileView(const File& file, const std::vector<u8>& data) : m_file(file), m_data(data) {}
+
+		// Reads past the end are cut short, like File::Get.
+		template<typename Type>
+		bool Get(Type& element, size_t& offset) const
 		{
-			m_linkedFiles.clear();
-			m_typeArray.clear();
+			size_t size = offset < m_data.size() ? std::min(sizeof(Type), m_data.size() - offset) : 0;
+			memcpy(&element, m_data.data() + offset, size);
+			offset += size;
+			return size == sizeof(Type);
+		}
 
-			m_offset = 0;
-			m_startOffset = 0;
-			m_entryCount = 0;
-			m_root = BinObject();
+		const std::vector<u8>& GetData() const { return m_data; }
+		std::string GetFullName() const { return m_file.GetFullName(); }
 
-			if (inLoadState != File::LoadState::Loaded)
-			{
-				m_loadState = inLoadState;
-				if (onLoadFunction)
-					onLoadFunction(*this);
-				return;
-			}
+	private:
+		const File& m_file;
+		const std::vector<u8>& m_data;
+	};
+
+	struct ParseContext
+	{
+		std::pmr::memory_resource* resource;
+		bool viewFileStrings;
+		const BinLazySource* lazySource; // Skip structs, containers and maps if set
+		StringPool* stringPool; // Strings are interned here instead of copied to resource if set
+	};
+
+	BinVariable ConstructType(const FileView& file, size_t& offset, Type type, const ParseContext& context);
+	static BinVariable ReadStruct(const FileView& file, size_t& offset, const ParseContext& context);
+	static BinVariable ReadContainer(const FileView& file, size_t& offset, const ParseContext& context);
+	static BinVariable ReadMap(const FileView& file, size_t& offset, const ParseContext& context);
 
-			char prop[4];
-			file->Read((u8*)prop, 4, m_offset);
-			if (memcmp(prop, "PROP", 4) != 0)
+	// Parses the nodes that were skipped in lazy mode, into an arena of its own so it doesn't have to share the bin's lock.
+	// Every load has its own, which isn't changed after it, so lazy nodes of values that a reload keeps or replaces are
+	// still parsed from the version of the file they came from.
+	class Bin::LazySource : public BinLazySource
+	{
+	public:
+		LazySource(File::Handle file, bool copyData, bool viewFileStrings, StringPool* stringPool) :
+			m_file(file),
+			m_copiedData(copyData ? file->GetData() : std::vector<u8>()),
+			m_view(*file, copyData ? m_copiedData : file->GetData()),
+			m_viewFileStrings(viewFileStrings),
+			m_stringPool(stringPool)
+		{
+		}
+
+		const FileView& GetView() const { return m_view; }
+		const Arena& GetArena() const { return m_arena; }
+
+	protected:
+		BinVariable Parse(size_t offset, u8 fileType) const override
+		{
+			// The node itself is parsed, its children are skipped again until they're accessed.
+			ParseContext context = { &m_arena, m_viewFileStrings, this, m_stringPool };
+			switch ((Type)fileType)
 			{
-				m_loadState = File::LoadState::FailedToLoad;
-				if (onLoadFunction)
-					onLoadFunction(*this);
-				return;
+			case Type::Struct:
+			case Type::Embedded:
+				return ReadStruct(m_view, offset, context);
+
+			case Type::Container:
+			case Type::Container2:
+				return ReadContainer(m_view, offset, context);
+
+			case Type::Map:
+				return ReadMap(m_view, offset, context);
+
+			default:
+				return BinVariable();
 			}
+		}
+
+	private:
+		File::Handle m_file;
+		std::vector<u8> m_copiedData;
+		FileView m_view;
+		mutable Arena m_arena;
+		bool m_viewFileStrings;
+		StringPool* m_stringPool;
+	};
+
+	// Counts a lookup for as long as it uses the index, see RetireIndex.
+	class Bin::IndexReader
+	{
+	public:
+		IndexReader(const Bin& bin)
+		{
+			static std::atomic<u32> threadCount = 0;
+			thread_local u32 threadIndex = threadCount.fetch_add(1, std::memory_order_relaxed);
+			ReaderCount& readers = bin.m_readerCounts[threadIndex % ParseShardCount];
 
-			u32 version;
-			file->Get(version, m_offset);
-			if (version > 3)
+			// If a load changed the generation in between, it might not have seen this count. Count again then.
+			// The index is only read once the count is in place, so it always belongs to a generation of its parity.
+			while (true)
 			{
-				m_loadState = File::LoadState::FailedToLoad;
-				if (onLoadFunction)
-					onLoadFunction(*this);
-				return;
+				u32 generation = bin.m_indexGeneration.load();
+				m_count = &readers.counts[generation & 1];
+				m_count->fetch_add(1);
+				if (bin.m_indexGeneration.load() == generation)
+				{
+					index = bin.m_publishedIndices[generation & 1].load();
+					break;
+				}
+				m_count->fetch_sub(1);
 			}
+		}
 
-			if (version >= 2)
-			{
-				u32 linkedFilesCount;
-				file->Get(linkedFilesCount, m_offset);
+		~IndexReader()
+		{
+			m_count->fetch_sub(1, std::memory_order_release);
+		}
 
-				for (u32 i = 0; i < linkedFilesCount; i++)
-				{
-					u16 stringLength;
-					file->Get(stringLength, m_offset);
+		EntryIndex* index;
 
-#if !defined(__EMSCRIPTEN__)
-					std::string fileName(stringLength, '\0');
-					file->Read((u8*)&fileName[0], stringLength, m_offset);
+	private:
+		std::atomic<u32>* m_count;
+	};
 
-					m_linkedFiles.push_back(fileName);
-#else
-					m_offset += stringLength;
-#endif
-				}
+	// Keeps out the lookups that parse and ParseAll, while a load or reset changes the bin.
+	class Bin::ExclusiveLock
+	{
+	public:
+		ExclusiveLock(Bin& bin) : m_bin(bin)
+		{
+			for (ParseShard& shard : m_bin.m_parseShards)
+				shard.mutex.lock();
+			m_bin.m_mutex.lock();
+		}
+
+		~ExclusiveLock()
+		{
+			m_bin.m_mutex.unlock();
+			for (ParseShard& shard : m_bin.m_parseShards)
+				shard.mutex.unlock();
+		}
+
+	private:
+		Bin& m_bin;
+	};
+
+	Bin::Bin()
+	{
+	}
+
+	Bin::~Bin()
+	{
+	}
+
+	void Bin::Load(const std::string& filePath, OnLoadFunction onLoadFunction, u32 loadFlags)
+	{
+		m_loadFlags = loadFlags;
+
+		m_file = File::Load(filePath.c_str(), [this, onLoadFunction](File::Handle file, File::LoadState inLoadState)
+		{
+			// The new index is built before locking, so lookups only wait for the bin to switch over to it.
+			File::LoadState loadState = inLoadState;
+			Header header;
+			std::unique_ptr<EntryIndex> index;
+			std::unique_ptr<LazySource> lazySource;
+			if (loadState == File::LoadState::Loaded)
+			{
+				const std::vector<u8>& data = file->GetData();
+				if (ReadHeader(data.data(), data.size(), header))
+					index = BuildIndex(std::move(header.entries), data);
+				else
+					loadState = File::LoadState::FailedToLoad;
+
+				// Values that a reload keeps can still have lazy nodes, which need the data they were parsed from.
+				if (index && (m_loadFlags & LazyNodes))
+					lazySource = std::make_unique<LazySource>(file, (m_loadFlags & IncrementalReload) != 0, (m_loadFlags & ViewFileStrings) != 0, GetStringPool());
 			}
 
-			file->Get(m_entryCount, m_offset);
-			if (m_entryCount != 0)
-				file->Get(m_typeArray, m_entryCount, m_offset);
+			std::unique_ptr<EntryIndex> previousIndex;
+			{
+				ExclusiveLock lock(*this);
+
+				// Values can only be kept if they were parsed from the previous version of this file, and don't point into it.
+				bool canKeepValues = m_loadState == File::LoadState::Loaded && (m_loadFlags & IncrementalReload) && (m_loadFlags & ViewFileStrings) == 0;
+
+				m_linkedFiles = std::move(header.linkedFiles);
+				m_typeArray = std::move(header.typeArray);
+				m_changedEntries.clear();
+				m_entryCount = (u32)m_typeArray.size();
+				m_startOffset = header.startOffset;
+				if (m_lazySource)
+					m_retiredLazySources.push_back(std::move(m_lazySource));
+				m_lazySource = std::move(lazySource);
+
+				if (index && (m_loadFlags & IncrementalReload))
+					ApplyChanges(m_currentIndex.get(), *index, canKeepValues);
+				else
+					ClearRoot();
+
+				m_loadState = loadState;
+				previousIndex = PublishIndex(std::move(index));
+			}
 
-			m_startOffset = m_offset;
-			m_loadState = File::LoadState::Loaded;
+			RetireIndex(std::move(previousIndex));
 			if (onLoadFunction)
 				onLoadFunction(*this);
 		});
 	}
 
+	std::unique_ptr<Bin::EntryIndex> Bin::BuildIndex(std::vector<Entry>&& entries, const std::vector<u8>& data) const
+	{
+		auto index = std::make_unique<EntryIndex>();
+		index->entries = std::move(entries);
+
+		// Index the root entries by hash, so Find can seek straight to them, and by class for the type scans.
+		index->entryIndices.reserve(index->entries.size());
+		for (u32 i = 0; i < index->entries.size(); i++)
+		{
+			index->entryIndices.emplace(index->entries[i].hash, i);
+			index->typeIndices[index->entries[i].typeHash].push_back(i);
+		}
+		index->slots = std::vector<std::atomic<const BinVariable*>>(index->entries.size());
+
+		if (m_loadFlags & IncrementalReload)
+		{
+			EntryIndex& result = *index;
+			result.entryChecksums.resize(result.entries.size());
+			ThreadPool::GetDefault().ParallelFor(result.entries.size(), 64, [&result, &data](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+					result.entryChecksums[i] = HashData(data.data() + result.entries[i].offset, result.entries[i].length);
+			});
+		}
+
+		return index;
+	}
+
+	// Makes index the one that lookups use. Every lock of ExclusiveLock has to be held. The previous index is returned,
+	// to be passed to RetireIndex once they're released.
+	std::unique_ptr<Bin::EntryIndex> Bin::PublishIndex(std::unique_ptr<EntryIndex> index)
+	{
+		// The half this overwrites may still be in use by lookups of an older generation, they keep the pointer they
+		// read. The index is only published once the generation that goes with it is known.
+		u32 generation = m_indexGeneration.load() + 1;
+		if (index)
+			index->generation = generation;
+		m_publishedIndices[generation & 1].store(index.get());
+		m_indexGeneration.store(generation);
+		std::swap(index, m_currentIndex);
+		return index;
+	}
+
+	// Frees an index once the lookups that use it are done. They're counted in the half of its generation, which only
+	// lookups of later generations of the same parity count in as well, so this may wait for those too.
+	void Bin::RetireIndex(std::unique_ptr<EntryIndex> index)
+	{
+		if (index == nullptr)
+			return;
+
+		u32 parity = index->generation & 1;
+		for (ReaderCount& readers : m_readerCounts)
+			while (readers.counts[parity].load() != 0)
+				std::this_thread::yield();
+	}
+
+	void Bin::ApplyChanges(const EntryIndex* previousIndex, EntryIndex& index, bool canKeepValues)
+	{
+		if (canKeepValues == false)
+			ClearRoot();
+
+		static const EntryIndex emptyIndex;
+		const EntryIndex& previous = previousIndex ? *previousIndex : emptyIndex;
+
+		// Entries that share a hash are found as the first one, so that's the only one that is compared.
+		std::unordered_map<u32, u32> previousIndices;
+		previousIndices.reserve(previous.entries.size());
+		for (u32 i = 0; i < previous.entries.size(); i++)
+			previousIndices.emplace(previous.entries[i].hash, i);
+
+		std::vector<const Entry*> changedEntries;
+		for (u32 i = 0; i < index.entries.size(); i++)
+		{
+			const Entry& entry = index.entries[i];
+			if (index.entryIndices[entry.hash] != i)
+				continue;
+
+			auto previousIndex = previousIndices.find(entry.hash);
+			if (previousIndex == previousIndices.end())
+			{
+				m_changedEntries.push_back({ entry.hash, EntryChange::Kind::Added });
+				continue;
+			}
+
+			// The previous load might not have kept checksums, if it was loaded without IncrementalReload.
+			const Entry& previousEntry = previous.entries[previousIndex->second];
+			bool hasChecksum = previousIndex->second < previous.entryChecksums.size();
+			bool isChanged = previousEntry.length != entry.length || hasChecksum == false || previous.entryChecksums[previousIndex->second] != index.entryChecksums[i];
+			if (isChanged)
+				m_changedEntries.push_back({ entry.hash, EntryChange::Kind::Changed });
+
+			if (isChanged && m_root.find(entry.hash) != m_root.end())
+				changedEntries.push_back(&entry);
+		}
+
+		for (u32 i = 0; i < previous.entries.size(); i++)
+		{
+			u32 hash = previous.entries[i].hash;
+			if (previousIndices[hash] != i || index.entryIndices.find(hash) != index.entryIndices.end())
+				continue;
+
+			m_changedEntries.push_back({ hash, EntryChange::Kind::Removed });
+			auto removed = m_root.find(hash);
+			if (removed != m_root.end())
+				m_replacedValues.push_back(m_root.extract(removed));
+		}
+
+		ParseEntries(index, changedEntries, true);
+		LinkSlots(index);
+	}
+
 	template<typename T>
-	static BinVariable ReadSimple(const File::Handle file, size_t& offset)
+	static BinVariable ReadSimple(const FileView& file, size_t& offset)
 	{
 		T data;
-		file->Get(data, offset);
+		file.Get(data, offset);
 		return data;
 	}
 
 	template<typename T, typename StorageType, typename FileType, int ElementCount>
-	static BinVariable ReadVector(const File::Handle file, size_t& offset)
+	static BinVariable ReadVector(const FileView& file, size_t& offset)
 	{
 		T data;
 		for (int i = 0; i < ElementCount; i++)
 		{
 			FileType element;
-			file->Get(element, offset);
+			file.Get(element, offset);
 			data[i] = (StorageType)element;
 		}
 
 		return data;
 	}
 
-	static BinVariable ReadArray(const File::Handle file, size_t& offset)
+	// Fixed-size elements are copied in one go, instead of creating a BinVariable for each of them.
+	static bool ReadTypedArray(const FileView& file, size_t& offset, Type type, u32 count, const ParseContext& context, BinVariable& result)
+	{
+		size_t elementSize = GetBinTypeSize(type);
+		const std::vector<u8>& data = file.GetData();
+		if (elementSize == 0 || offset + elementSize * count > data.size())
+			return false;
+
+		result = BinVariable::MakeTypedArray(type, data.data() + offset, count, context.resource);
+		offset += elementSize * count;
+		return true;
+	}
+
+	static BinVariable ReadArray(const FileView& file, size_t& offset, const ParseContext& context)
 	{
 		Type type;
-		file->Get(type, offset);
+		file.Get(type, offset);
 
 		u8 count;
-		file->Get(count, offset);
+		file.Get(count, offset);
 
-		BinArray result;
+		BinVariable typedResult;
+		if (ReadTypedArray(file, offset, type, count, context, typedResult))
+			return typedResult;
+
+		BinArray result(context.resource);
 		result.resize(count);
 		for (int i = 0; i < count; i++)
-			result[i] = ConstructType(file, offset, type);
+			result[i] = ConstructType(file, offset, type, context);
 
 		return result;
 	}
 
-	static BinVariable ReadU16Vec3(const File::Handle file, size_t& offset) { return ReadVector<glm::ivec3, glm::ivec3::value_type, u16, 3>(file, offset); }
-	static BinVariable ReadVec4(const File::Handle file, size_t& offset) { return ReadVector<glm::vec4, glm::vec4::value_type, float, 4>(file, offset); }
-	static BinVariable ReadVec3(const File::Handle file, size_t& offset) { return ReadVector<glm::vec3, glm::vec3::value_type, float, 3>(file, offset); }
-	static BinVariable ReadVec2(const File::Handle file, size_t& offset) { return ReadVector<glm::vec2, glm::vec2::value_type, float, 2>(file, offset); }
-	static BinVariable ReadRGBA(const File::Handle file, size_t& offset) { return ReadVector<glm::ivec4, glm::ivec4::value_type, u8, 4>(file, offset); }
+	static BinVariable ReadU16Vec3(const FileView& file, size_t& offset) { return ReadVector<glm::ivec3, glm::ivec3::value_type, u16, 3>(file, offset); }
+	static BinVariable ReadVec4(const FileView& file, size_t& offset) { return ReadVector<glm::vec4, glm::vec4::value_type, float, 4>(file, offset); }
+	static BinVariable ReadVec3(const FileView& file, size_t& offset) { return ReadVector<glm::vec3, glm::vec3::value_type, float, 3>(file, offset); }
+	static BinVariable ReadVec2(const FileView& file, size_t& offset) { return ReadVector<glm::vec2, glm::vec2::value_type, float, 2>(file, offset); }
+	static BinVariable ReadRGBA(const FileView& file, size_t& offset) { return ReadVector<glm::ivec4, glm::ivec4::value_type, u8, 4>(file, offset); }
 
-	static BinVariable ReadString(const File::Handle file, size_t& offset)
+	static BinVariable ReadString(const FileView& file, size_t& offset, const ParseContext& context)
 	{
 		u16 stringLength;
-		file->Get(stringLength, offset);
+		file.Get(stringLength, offset);
 
-		std::string data = std::string(stringLength, '\0');
-		file->Read((u8*)data.c_str(), stringLength, offset);
-		return data;
+		const std::vector<u8>& data = file.GetData();
+		if (offset + stringLength > data.size())
+		{
+			offset = data.size();
+			return BinString();
+		}
+
+		const char* source = (const char*)data.data() + offset;
+		offset += stringLength;
+		if (context.viewFileStrings || stringLength == 0)
+			return BinString(source, stringLength);
+		if (context.stringPool)
+			return context.stringPool->Intern(BinString(source, stringLength));
+
+		char* copy = (char*)context.resource->allocate(stringLength, 1);
+		memcpy(copy, source, stringLength);
+		return BinString(copy, stringLength);
 	}
 
-	static BinVariable ReadMap(File::Handle file, size_t& offset)
+	static BinVariable ReadMap(const FileView& file, size_t& offset, const ParseContext& context)
 	{
 		Type keyType;
-		file->Get(keyType, offset);
+		file.Get(keyType, offset);
 
 		Type valueType;
-		file->Get(valueType, offset);
+		file.Get(valueType, offset);
 
 		u32 length;
-		file->Get(length, offset);
+		file.Get(length, offset);
 		size_t begin = offset;
 
 		u32 count;
-		file->Get(count, offset);
+		file.Get(count, offset);
 
-		BinMap map;
+		// Keys and values are moved in, copying them would allocate them outside of our memory resource.
+		BinMap::Storage pairs(context.resource);
+		pairs.reserve(count);
 		for (u32 i = 0; i < count; i++)
 		{
-			BinVariable key =	ConstructType(file, offset, keyType);
-			BinVariable value =	ConstructType(file, offset, valueType);
-			map[key] = value;
+			BinVariable key =	ConstructType(file, offset, keyType, context);
+			BinVariable value =	ConstructType(file, offset, valueType, context);
+			pairs.emplace_back(std::move(key), std::move(value));
 		}
 
+		BinMap map(context.resource);
+		map.SetPairs(std::move(pairs));
+
 		assert(offset - begin == length);
 		return map;
 	}
 
-	static BinVariable ReadStruct(File::Handle file, size_t& offset)
+	static BinVariable ReadStruct(const FileView& file, size_t& offset, const ParseContext& context)
 	{
 		u32 typeHash;
-		file->Get(typeHash, offset);
+		file.Get(typeHash, offset);
 		if (typeHash == 0)
-			return BinObject();
+			return BinObject(context.resource);
 
 		u32 length;
-		file->Get(length, offset);
+		file.Get(length, offset);
 		size_t begin = offset;
 
 		u16 elementCount;
-		file->Get(elementCount, offset);
+		file.Get(elementCount, offset);
 
-		BinObject result;
+		BinObject result(context.resource);
 		result.SetTypeHash(typeHash);
 
 		BinDebug("Struct TypeHash: %x (length: %u, element count: %u)", typeHash, length, elementCount);
 
+		BinObject::Map variables(context.resource);
+		variables.reserve(elementCount);
 		for (u16 i = 0; i < elementCount; i++)
 		{
 			Type type;
 			u32 entryHash;
-			file->Get(entryHash, offset);
-			file->Get(type, offset);
+			file.Get(entryHash, offset);
+			file.Get(type, offset);
 
-			result[entryHash] = ConstructType(file, offset, type);
+			variables.emplace_back(entryHash, ConstructType(file, offset, type, context));
 		}
 
+		result.SetVariables(std::move(variables));
 		assert(offset - begin == length);
 		return result;
 	}
 
-	static BinVariable ReadContainer(File::Handle file, size_t& offset)
+	static BinVariable ReadContainer(const FileView& file, size_t& offset, const ParseContext& context)
 	{
 		Type type;
-		file->Get(type, offset);
+		file.Get(type, offset);
 
 		u32 length;
-		file->Get(length, offset);
+		file.Get(length, offset);
 		size_t begin = offset;
 
 		u32 elementCount;
-		file->Get(elementCount, offset);
+		file.Get(elementCount, offset);
 
 		BinDebug("Container containing types %i (length: %u, element count: %u)", (int)type, length, elementCount);
 
-		BinArray resultArray;
+		BinVariable typedResult;
+		if (ReadTypedArray(file, offset, type, elementCount, context, typedResult))
+		{
+			assert(offset - begin == length);
+			return typedResult;
+		}
+
+		BinArray resultArray(context.resource);
 		resultArray.resize(elementCount);
 		for (u32 i = 0; i < elementCount; i++)
 		{
@@ -286,7 +561,7 @@ namespace LeagueLib
 			BinDebug("Element %d", i);
 			BinIncDepth();
 
-			resultArray[i] = ConstructType(file, offset, type);
+			resultArray[i] = ConstructType(file, offset, type, context);
 
 			BinDecDepth();
 			BinDecDepth();
@@ -296,7 +571,7 @@ namespace LeagueLib
 		return resultArray;
 	}
 
-	static BinVariable ReadMat4(File::Handle file, size_t& offset)
+	static BinVariable ReadMat4(const FileView& file, size_t& offset, const ParseContext& context)
 	{
 		glm::mat4 resultMatrix;
 		for (int x = 0; x < 4; x++)
@@ -304,15 +579,68 @@ namespace LeagueLib
 			for (int y = 0; y < 4; y++)
 			{
 				auto& data = resultMatrix[x][y];
-				file->Get(data, offset);
+				file.Get(data, offset);
 			}
 		}
 
-		return resultMatrix;
+		return BinVariable(resultMatrix, context.resource);
+	}
+
+	// Skips over a struct, container or map using its length, and returns a node that parses it on first access.
+	static BinVariable SkipLazy(const FileView& file, size_t& offset, Type type, const ParseContext& context)
+	{
+		size_t start = offset;
+		u8 typeIndex;
+		switch (type)
+		{
+		case Type::Struct:
+		case Type::Embedded:
+		{
+			u32 typeHash = 0;
+			file.Get(typeHash, offset);
+			if (typeHash == 0)
+				return BinObject(context.resource);
+
+			typeIndex = BinTypeIndex<BinObject>;
+			break;
+		}
+
+		case Type::Map:
+			offset += 2 * sizeof(Type);
+			typeIndex = BinTypeIndex<BinMap>;
+			break;
+
+		default:
+			offset += sizeof(Type);
+			typeIndex = BinTypeIndex<BinArray>;
+			break;
+		}
+
+		u32 length = 0;
+		file.Get(length, offset);
+		offset += length;
+
+		return BinVariable::MakeLazy(*context.lazySource, start, (u8)type, typeIndex, context.resource);
 	}
 
-	BinVariable ConstructType(const File::Handle file, size_t& offset, Type type)
+	BinVariable ConstructType(const FileView& file, size_t& offset, Type type, const ParseContext& context)
 	{
+		if (context.lazySource)
+		{
+			switch (type)
+			{
+			case Type::Struct:
+			case Type::Embedded:
+			case Type::Container:
+			case Type::Container2:
+			case Type::Map:
+				return SkipLazy(file, offset, type, context);
+
+			default:
+				break;
+			}
+		}
+
 		BinVariable result;
 
 		switch (type)
@@ -326,27 +654,28 @@ namespace LeagueLib
 		case Type::U32:		BinDebug("Reading a u32 (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadSimple<u32>(file, offset); break;
 		case Type::S64:		BinDebug("Reading a i64 (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadSimple<i64>(file, offset); break;
 		case Type::U64:		BinDebug("Reading a u64 (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadSimple<u64>(file, offset); break;
+		case Type::Path:	BinDebug("Reading a path (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadSimple<u64>(file, offset); break;
 		case Type::Float:	BinDebug("Reading a float (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadSimple<float>(file, offset); break;
 		case Type::Hash:	BinDebug("Reading a u32 (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadSimple<u32>(file, offset); break;
-		case Type::String:	BinDebug("Reading a String (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadString(file, offset); break;
+		case Type::String:	BinDebug("Reading a String (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadString(file, offset, context); break;
 		case Type::RGBA:	BinDebug("Reading a RGBA (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadRGBA(file, offset); break;
 		case Type::Vec2f:	BinDebug("Reading a Vec2 (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadVec2(file, offset); break;
 		case Type::Vec3f:	BinDebug("Reading a Vec3 (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadVec3(file, offset); break;
 		case Type::Vec4f:	BinDebug("Reading a Vec4 (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadVec4(file, offset); break;
-		case Type::Array:	BinDebug("Reading a Array (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadArray(file, offset); break;
-		case Type::Map:		BinDebug("Reading a Map (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadMap(file, offset); break;
-		case Type::Mat4:	BinDebug("Reading a Mat4 (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadMat4(file, offset); break;
+		case Type::Array:	BinDebug("Reading a Array (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadArray(file, offset, context); break;
+		case Type::Map:		BinDebug("Reading a Map (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadMap(file, offset, context); break;
+		case Type::Mat4:	BinDebug("Reading a Mat4 (Type: %d, offset %zu)", (int)type, offset);	BinIncDepth(); result = ReadMat4(file, offset, context); break;
 
 		case Type::Struct:
 		case Type::Embedded:
 			BinDebug("Reading a struct (Type: %d, offset %zu)", (int)type, offset); BinIncDepth();
-			result = ReadStruct(file, offset);
+			result = ReadStruct(file, offset, context);
 			break;
 
 		case Type::Container:
 		case Type::Container2:
 			BinDebug("Reading a container (Type: %d, offset %zu)", (int)type, offset); BinIncDepth();
-			result = ReadContainer(file, offset);
+			result = ReadContainer(file, offset, context);
 			break;
 
 		case Type::Flag:
@@ -358,7 +687,7 @@ namespace LeagueLib
 		default:
 		{
 			char buffer[2048];
-			snprintf(buffer, 2048, "Unknown type %d in %s", (int)type, file->GetFullName().c_str());
+			snprintf(buffer, 2048, "Unknown type %d in %s", (int)type, file.GetFullName().c_str());
 			throw new std::exception(buffer);
 		}
 		};
@@ -367,104 +696,359 @@ namespace LeagueLib
 		return result;
 	}
 
-	const BinVariable& Bin::Find(u32 hashToFind)
+	const std::vector<Bin::Entry>& Bin::GetEntries() const
 	{
-		std::lock_guard t(m_mutex);
-		assert(m_file && m_loadState == File::LoadState::Loaded);
-		m_offset = m_startOffset; // Reset offset to start offset.
-
-		// Go over each root object, create it and append it to m_root
-		for (u32 i = 0; i < m_entryCount; i++)
-		{
-			BinDebug("Entry %u", i);
-			u32 length;
-			m_file->Get(length, m_offset);
-			size_t begin = m_offset;
-
-			u32 rootHash;
-			m_file->Get(rootHash, m_offset);
-			
-#if BIN_FAST_FIND
-			// Check if we found our hash, if not, go to the next object.
-			if (rootHash != hashToFind)
+		static const std::vector<Entry> none;
+		const EntryIndex* index = GetPublishedIndex();
+		return index ? index->entries : none;
+	}
+
+	const Bin::Entry* Bin::FindEntry(u32 hash) const
+	{
+		const EntryIndex* index = GetPublishedIndex();
+		if (index == nullptr)
+			return nullptr;
+
+		auto entry = index->entryIndices.find(hash);
+		return entry != index->entryIndices.end() ? &index->entries[entry->second] : nullptr;
+	}
+
+	std::vector<const Bin::Entry*> Bin::GetEntriesOfType(u32 typeHash) const
+	{
+		std::vector<const Entry*> result;
+		const EntryIndex* index = GetPublishedIndex();
+		if (index == nullptr)
+			return result;
+
+		auto indices = index->typeIndices.find(typeHash);
+		if (indices == index->typeIndices.end())
+			return result;
+
+		result.reserve(indices->second.size());
+		for (u32 entry : indices->second)
+			result.push_back(&index->entries[entry]);
+		return result;
+	}
+
+	bool Bin::ReadHeader(const u8* data, size_t size, Header& header)
+	{
+		size_t offset = 0;
+		if (size < 4 || memcmp(data, "PROP", 4) != 0)
+			return false;
+		offset += 4;
+
+		if (ReadRaw(data, size, offset, header.version) == false || header.version > 3)
+			return false;
+
+		if (header.version >= 2)
+		{
+			u32 linkedFilesCount;
+			if (ReadRaw(data, size, offset, linkedFilesCount) == false)
+				return false;
+
+			for (u32 i = 0; i < linkedFilesCount; i++)
 			{
-				m_offset = begin + length;
-				continue;
-			}
+				u16 stringLength;
+				if (ReadRaw(data, size, offset, stringLength) == false || offset + stringLength > size)
+					return false;
+
+#if !defined(__EMSCRIPTEN__)
+				header.linkedFiles.emplace_back((const char*)data + offset, stringLength);
 #endif
+				offset += stringLength;
+			}
+		}
 
-			u16 count;
-			m_file->Get(count, m_offset);
+		u32 entryCount;
+		if (ReadRaw(data, size, offset, entryCount) == false || offset + (size_t)entryCount * sizeof(u32) > size)
+			return false;
+
+		header.typeArray.resize(entryCount);
+		if (entryCount != 0)
+			memcpy(header.typeArray.data(), data + offset, entryCount * sizeof(u32));
+		offset += entryCount * sizeof(u32);
+		header.startOffset = offset;
+
+		// Only the length and hash of every entry is read, a truncated file keeps the entries that fit.
+		header.entries.reserve(entryCount);
+		for (u32 i = 0; i < entryCount; i++)
+		{
+			Entry entry;
+			if (ReadRaw(data, size, offset, entry.length) == false)
+				break;
+
+			// Every entry has at least its hash and field count, anything shorter is malformed rather than truncated.
+			if (entry.length < sizeof(u32) + sizeof(u16))
+				return false;
+
+			entry.offset = offset;
+			if (entry.offset + entry.length > size || ReadRaw(data, size, offset, entry.hash) == false)
+				break;
+
+			entry.typeHash = header.typeArray[i];
+			header.entries.push_back(entry);
+			offset = entry.offset + entry.length;
+		}
+
+		return true;
+	}
+
+	// Parses an entry that hasn't been parsed yet. Returns nullptr if a load replaced index while this was waiting.
+	const BinVariable* Bin::Find(EntryIndex& index, u32 slot)
+	{
+		ParseShard& shard = m_parseShards[slot % ParseShardCount];
+		std::lock_guard shardLock(shard.mutex);
+
+		// Another thread might have parsed it while we were waiting for the lock.
+		if (const BinVariable* value = index.slots[slot].load(std::memory_order_acquire))
+			return value;
+
+		// The index is only replaced with every shard locked, and the file belongs to the new one then.
+		if (m_currentIndex.get() != &index)
+			return nullptr;
+
+		BinVariable value = ParseEntry(index.entries[slot], &shard.arena);
+
+		std::lock_guard t(m_mutex);
+		return &StoreEntry(index, slot, std::move(value), false);
+	}
+
+	// Moves a parsed entry into the root, unless it's already there and replace is false. m_mutex has to be locked.
+	const BinVariable& Bin::StoreEntry(EntryIndex& index, u32 slot, BinVariable&& value, bool replace)
+	{
+		std::atomic<const BinVariable*>& current = index.slots[slot];
+		if (const BinVariable* existing = current.load(std::memory_order_relaxed))
+			if (replace == false)
+				return *existing;
+
+		// Lookups might still be reading the previous value, so it's set aside instead of overwritten.
+		u32 hash = index.entries[slot].hash;
+		auto previous = m_root.find(hash);
+		if (previous != m_root.end())
+			m_replacedValues.push_back(m_root.extract(previous));
+
+		BinVariable& result = m_root.emplace(hash, std::move(value)).first->second;
+		current.store(&result, std::memory_order_release);
+		return result;
+	}
+
+	// Points the slots of a new index at the values that were kept in the root.
+	void Bin::LinkSlots(EntryIndex& index)
+	{
+		for (const auto& [hash, slot] : index.entryIndices)
+		{
+			auto value = m_root.find(hash);
+			index.slots[slot].store(value != m_root.end() ? &value->second : nullptr, std::memory_order_release);
+		}
+	}
+
+	BinObject Bin::ParseEntry(const Entry& entry, std::pmr::memory_resource* resource) const
+	{
+		FileView file = m_lazySource ? m_lazySource->GetView() : FileView(*m_file, m_file->GetData());
+		size_t offset = entry.offset + sizeof(u32); // Skip the hash
+		u16 count;
+		file.Get(count, offset);
+
+		// Collect every single element inside our object.
+		const BinLazySource* lazySource = m_lazySource.get();
+		ParseContext context = { resource, (m_loadFlags & ViewFileStrings) != 0, lazySource, GetStringPool() };
+
+		BinObject::Map variables(resource);
+		variables.reserve(count);
+		for (int j = 0; j < count; j++)
+		{
+			Type type;
+			u32 entryHash;
+			file.Get(entryHash, offset);
+			file.Get(type, offset);
+
+			BinDebug("Type %d, entryHash %x, offset %zu", (int)type, entryHash, offset);
+			variables.emplace_back(entryHash, ConstructType(file, offset, type, context));
+		}
 
-			// Collect every single element inside our object.
-			BinObject object; // TODO: Set type hash
-			for (int j = 0; j < count; j++)
+		BinObject object(resource);
+		object.SetTypeHash(entry.typeHash);
+		object.SetVariables(std::move(variables));
+
+		assert(offset - entry.offset == entry.length);
+		return object;
+	}
+
+	void Bin::ParseAll()
+	{
+		std::lock_guard t(m_mutex);
+		EntryIndex* index = m_currentIndex.get();
+		if (index == nullptr)
+			return;
+
+		std::vector<const Entry*> entries;
+		for (u32 i = 0; i < index->entries.size(); i++)
+			if (index->entryIndices[index->entries[i].hash] == i && index->slots[i].load(std::memory_order_relaxed) == nullptr)
+				entries.push_back(&index->entries[i]);
+
+		ParseEntries(*index, entries);
+	}
+
+	void Bin::ParseEntriesOfType(u32 typeHash)
+	{
+		std::lock_guard t(m_mutex);
+		EntryIndex* index = m_currentIndex.get();
+		if (index == nullptr)
+			return;
+
+		std::vector<const Entry*> entries;
+		for (const Entry* entry : GetEntriesOfType(typeHash))
+		{
+			u32 slot = index->entryIndices[entry->hash];
+			if (&index->entries[slot] == entry && index->slots[slot].load(std::memory_order_relaxed) == nullptr)
+				entries.push_back(entry);
+		}
+
+		ParseEntries(*index, entries);
+	}
+
+	void Bin::ParseEntries(EntryIndex& index, const std::vector<const Entry*>& entries, bool replace)
+	{
+		// Ranges borrow an arena that no other range is using, and only create one if they're all taken.
+		std::mutex arenaMutex;
+		std::vector<Arena*> freeArenas;
+		for (auto& arena : m_workerArenas)
+			freeArenas.push_back(arena.get());
+
+		// Every root entry is length-prefixed, so they can be parsed independently into their own slot.
+		// Moving the results into the cache keeps them in the arena they were parsed in.
+		std::vector<BinVariable> objects(entries.size());
+		ThreadPool::GetDefault().ParallelFor(entries.size(), 16, [this, &entries, &objects, &arenaMutex, &freeArenas](size_t begin, size_t end)
+		{
+			Arena* arena;
 			{
-				Type type;
-				u32 entryHash;
-				m_file->Get(entryHash, m_offset);
-				m_file->Get(type, m_offset);
+				std::lock_guard lock(arenaMutex);
+				if (freeArenas.empty())
+				{
+					m_workerArenas.push_back(std::make_unique<Arena>());
+					freeArenas.push_back(m_workerArenas.back().get());
+				}
 
-				BinDebug("Type %d, entryHash %x, offset %zu", (int)type, entryHash, m_offset);
-				object[entryHash] = ConstructType(m_file, m_offset, type);
+				arena = freeArenas.back();
+				freeArenas.pop_back();
 			}
 
-			assert(m_offset - begin == length);
-			m_root[rootHash] = object;
-#if BIN_FAST_FIND
-			return m_root[rootHash];
-#endif
-		}
+			for (size_t i = begin; i < end; i++)
+				objects[i] = ParseEntry(*entries[i], arena);
 
-#if !BIN_FAST_FIND
-		return m_root[hashToFind];
-#else
-		// If we haven't found it, return an empty object.
-		static const BinVariable none;
-		return none;
-#endif
+			std::lock_guard lock(arenaMutex);
+			freeArenas.push_back(arena);
+		});
+
+		// Merge in file order, so that the result doesn't depend on scheduling. Entries that were parsed by a lookup in
+		// the meantime are left alone, as their values may already be in use.
+		m_root.reserve(m_root.size() + entries.size());
+		for (size_t i = 0; i < entries.size(); i++)
+			StoreEntry(index, (u32)(entries[i] - index.entries.data()), std::move(objects[i]), replace);
 	}
 
 	const BinVariable& Bin::operator[](u32 hash)  const
 	{
+		static const BinVariable none;
+
+		while (true)
+		{
+			IndexReader reader(*this);
+			if (reader.index == nullptr)
+				return none;
+
+			auto entry = reader.index->entryIndices.find(hash);
+			if (entry == reader.index->entryIndices.end())
+				return none;
+
 #if BIN_USE_CACHE
-		auto result = m_root.find(hash);
-		if (result != m_root.end())
-			return result->second;
+			if (const BinVariable* value = reader.index->slots[entry->second].load(std::memory_order_acquire))
+				return *value;
 #endif
 
-		if (m_file && m_loadState == File::LoadState::Loaded)
-			return const_cast<Bin*>(this)->Find(hash);
-		static const BinVariable none;
-		return none;
+			// Otherwise a load or reset replaced the index while we were waiting to parse. Look again with a new reader,
+			// which is counted in the generation of the index it uses.
+			if (const BinVariable* value = const_cast<Bin*>(this)->Find(*reader.index, entry->second))
+				return *value;
+		}
 	}
 
 	const BinVariable& Bin::operator[](std::string_view name)  const
 	{
-		u32 hash = FNV1Hash(name.data());
-#if BIN_USE_CACHE
-		auto result = m_root.find(hash);
-		if (result != m_root.end())
-			return result->second;
-#endif
+		return operator[](HashName(name));
+	}
 
-		if (m_file && m_loadState == File::LoadState::Loaded)
-			return const_cast<Bin*>(this)->Find(hash);
-		static const BinVariable none;
-		return none;
+	const BinVariable& Bin::operator[](BinFieldKey key) const
+	{
+		return operator[](key.hash);
 	}
 
-	void Bin::Reset()
+	Bin::ArenaUsage Bin::GetArenaUsage() const
 	{
+		ArenaUsage usage = { 0, 0 };
+		for (const ParseShard& shard : m_parseShards)
+		{
+			usage.usedBytes += shard.arena.GetUsedBytes();
+			usage.reservedBytes += shard.arena.GetReservedBytes();
+		}
+
+		for (const auto& arena : m_workerArenas)
+		{
+			usage.usedBytes += arena->GetUsedBytes();
+			usage.reservedBytes += arena->GetReservedBytes();
+		}
+
+		if (m_lazySource)
+		{
+			usage.usedBytes += m_lazySource->GetArena().GetUsedBytes();
+			usage.reservedBytes += m_lazySource->GetArena().GetReservedBytes();
+		}
+
+		for (const auto& lazySource : m_retiredLazySources)
+		{
+			usage.usedBytes += lazySource->GetArena().GetUsedBytes();
+			usage.reservedBytes += lazySource->GetArena().GetReservedBytes();
+		}
+		return usage;
+	}
+
+	void Bin::ClearRoot()
+	{
+		// The values have to be gone before their memory is released. Their deallocations are no-ops, but destroying them
+		// still visits every node: arrays expanded from typed arrays, and values copied into a tree, are on the default
+		// resource instead of an arena and have to be freed one by one. So this is linear in the size of the tree, it
+		// only saves the frees of the nodes that are in the arenas.
+		if (m_currentIndex)
+			for (auto& slot : m_currentIndex->slots)
+				slot.store(nullptr, std::memory_order_relaxed);
 		m_root = {};
-		m_linkedFiles.clear();
-		m_typeArray.clear();
+		m_replacedValues.clear();
+		for (ParseShard& shard : m_parseShards)
+			shard.arena.Release();
+		for (auto& arena : m_workerArenas)
+			arena->Release();
+		m_retiredLazySources.clear();
+	}
+
+	void Bin::Reset()
+	{
+		std::unique_ptr<EntryIndex> previousIndex;
+		{
+			ExclusiveLock lock(*this);
+			ClearRoot();
+			m_linkedFiles.clear();
+			m_typeArray.clear();
+			m_changedEntries.clear();
 
-		m_offset = 0;
-		m_startOffset = 0;
-		m_entryCount = 0;
+			m_startOffset = 0;
+			m_entryCount = 0;
+
+			m_file = nullptr;
+			m_lazySource = nullptr;
+			m_loadState = Spek::File::LoadState::NotLoaded;
+			previousIndex = PublishIndex(nullptr);
+		}
 
-		m_file = nullptr;
-		m_loadState = Spek::File::LoadState::NotLoaded;
+		RetireIndex(std::move(previousIndex));
 	}
 }
\ No newline at end of file
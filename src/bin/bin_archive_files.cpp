@@ -0,0 +1,101 @@
+#include <league_lib/bin/bin_archive_files.hpp>
+#include <league_lib/util/thread_pool.hpp>
+#include <league_lib/wad/wad_filesystem.hpp>
+
+#include <atomic>
+#include <cstring>
+#include <unordered_map>
+
+namespace LeagueLib
+{
+	BinArchiveFiles::BinArchiveFiles(const std::vector<const WAD*>& archives, const FileFilterFunction& filter)
+	{
+		AddFiles(archives, 0, filter);
+	}
+
+	BinArchiveFiles::BinArchiveFiles(const std::vector<const WAD*>& archives, const std::vector<const WAD*>& otherArchives, const FileFilterFunction& filter)
+	{
+		AddFiles(archives, 0, filter);
+		AddFiles(otherArchives, 1, filter);
+	}
+
+	void BinArchiveFiles::AddFiles(const std::vector<const WAD*>& archives, size_t set, const FileFilterFunction& filter)
+	{
+		std::unordered_map<WAD::FileNameHash, size_t> fileIndices;
+		for (size_t i = 0; i < m_files.size(); i++)
+			fileIndices.emplace(m_files[i].hash, i);
+
+		for (const WAD* archive : archives)
+		{
+			for (const auto& [hash, fileData] : *archive)
+			{
+				if (fileData.fileSize < 4)
+					continue;
+
+				auto index = fileIndices.find(hash);
+				if (index != fileIndices.end() && m_files[index->second].archives[set] != nullptr)
+					continue;
+
+				if (filter && filter(*archive, hash) == false)
+					continue;
+
+				if (index == fileIndices.end())
+				{
+					index = fileIndices.emplace(hash, m_files.size()).first;
+					m_files.push_back({ hash });
+				}
+				m_files[index->second].archives[set] = archive;
+			}
+		}
+	}
+
+	std::vector<const WAD*> BinArchiveFiles::GetArchives(const WADFileSystem& fileSystem)
+	{
+		std::vector<const WAD*> archives;
+		for (const auto& archive : fileSystem.GetArchives())
+			archives.push_back(archive.get());
+		return archives;
+	}
+
+	bool BinArchiveFiles::ExtractBin(const WAD& archive, WAD::FileNameHash fileHash, std::vector<u8>& data)
+	{
+		// Most files aren't bins, checking the magic first saves decompressing all of them.
+		u8 magic[4];
+		if (archive.ExtractFileStart(fileHash, magic, sizeof(magic)) == false || memcmp(magic, "PROP", 4) != 0)
+			return false;
+
+		return archive.ExtractFile(fileHash, data);
+	}
+
+	size_t BinArchiveFiles::ForEach(const OnFileFunction& onFile) const
+	{
+		std::atomic<size_t> count = 0;
+		ThreadPool::GetDefault().ParallelFor(m_files.size(), 4, [this, &onFile, &count](size_t begin, size_t end)
+		{
+			std::vector<u8> data[2];
+			for (size_t i = begin; i < end; i++)
+			{
+				const File& file = m_files[i];
+				if (file.archives[0] && file.archives[1])
+				{
+					u64 checksum = file.archives[0]->GetFileChecksum(file.hash);
+					if (checksum != 0 && checksum == file.archives[1]->GetFileChecksum(file.hash))
+						continue;
+				}
+
+				bool isBin = true;
+				for (size_t set = 0; set < 2 && isBin; set++)
+				{
+					data[set].clear();
+					if (file.archives[set])
+						isBin = ExtractBin(*file.archives[set], file.hash, data[set]);
+				}
+
+				if (isBin && onFile(file, data))
+					count++;
+			}
+		});
+
+		return count;
+	}
+}
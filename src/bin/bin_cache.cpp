@@ -0,0 +1,683 @@
+#include <league_lib/bin/bin_cache.hpp>
+#include <league_lib/bin/bin_parser.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+
+namespace LeagueLib
+{
+	// Layout of the cache: the header, the linked files, the entries sorted by hash, the nodes, the values and finally
+	// the strings. Every section starts at a multiple of 16 bytes, as do typed arrays in the values.
+	struct BinCache::Header
+	{
+		char magic[4];
+		u32 version;
+		u64 sourceChecksum;
+		u32 binVersion;
+		u32 linkedFileCount;
+		u32 entryCount;
+		u32 nodeCount;
+		u32 valuesSize;
+		u32 stringsSize;
+		u32 padding[2];
+	};
+
+	struct BinCache::LinkedFile
+	{
+		u32 offset;
+		u32 length;
+	};
+
+	struct BinCache::Entry
+	{
+		u32 hash;
+		u32 node;
+	};
+
+	struct BinCacheNode::Node
+	{
+		u32 nameHash;
+		u32 typeHash;
+		u32 count;		// Fields, elements or pairs, or the length of a string
+		u32 offset;		// First child in the nodes, or the value in the values or strings
+		BinType type;
+		BinType elementType;
+		BinType valueType;
+		u8 padding;
+	};
+
+	static constexpr char CacheMagic[4] = { 'B', 'C', 'C', 'H' };
+	static constexpr u32 CacheVersion = 1;
+	static constexpr size_t SectionAlignment = 16;
+
+	static size_t Align(size_t offset, size_t alignment)
+	{
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Values are aligned to their size, except for the ones that aren't a power of two, which are made of floats.
+	static size_t GetValueAlignment(BinType type)
+	{
+		size_t size = GetBinTypeSize(type);
+		if (size >= SectionAlignment)
+			return SectionAlignment;
+		return (size & (size - 1)) == 0 ? size : sizeof(float);
+	}
+
+	static bool IsStruct(BinType type)
+	{
+		return type == BinType::Struct || type == BinType::Embedded;
+	}
+
+	static bool IsContainer(BinType type)
+	{
+		return type == BinType::Container || type == BinType::Container2 || type == BinType::Array;
+	}
+
+	// Sign extends signed keys, so that they can be found with their value cast to u64.
+	static bool GetInteger(BinType type, const u8* data, u64& value)
+	{
+		auto read = [data, &value](auto result)
+		{
+			memcpy(&result, data, sizeof(result));
+			value = (u64)result;
+			return true;
+		};
+
+		switch (type)
+		{
+		case BinType::Bool:
+		case BinType::Flag:
+		case BinType::U8:	return read(u8());
+		case BinType::S8:	return read(i8());
+		case BinType::S16:	return read(i16());
+		case BinType::U16:	return read(u16());
+		case BinType::S32:	return read(i32());
+		case BinType::U32:
+		case BinType::Hash:
+		case BinType::Link:	return read(u32());
+		case BinType::S64:	return read(i64());
+		case BinType::U64:
+		case BinType::Path:	return read(u64());
+
+		default:
+			return false;
+		}
+	}
+
+	// Collects the nodes of a PROP file. The children of a struct, container or map are only known once it ends, so
+	// they're kept aside until then and added to the nodes together, right after each other.
+	class BinCache::Builder : public BinVisitor
+	{
+	public:
+		using Node = BinCacheNode::Node;
+
+		Builder()
+		{
+			m_frames.emplace_back();
+		}
+
+		Action OnLinkedFile(std::string_view name) override
+		{
+			linkedFiles.push_back({ AddString(name), (u32)name.size() });
+			return Enter;
+		}
+
+		Action OnBeginEntry(u32 hash, u32 typeHash) override
+		{
+			Node& node = AddNode(BinType::Embedded);
+			node.nameHash = hash;
+			node.typeHash = typeHash;
+			m_frames.emplace_back();
+			return Enter;
+		}
+
+		Action OnEndEntry(u32) override
+		{
+			EndFrame();
+			return Enter;
+		}
+
+		Action OnField(u32 hash, BinType type) override
+		{
+			m_frames.back().fieldHash = hash;
+			m_frames.back().fieldType = type;
+			return Enter;
+		}
+
+		Action OnValue(const BinValueView& value) override
+		{
+			Frame& frame = m_frames.back();
+			if (frame.isTypedArray)
+			{
+				values.insert(values.end(), value.data, value.data + value.size);
+				return Enter;
+			}
+
+			Node& node = AddNode(value.type);
+			if (value.type == BinType::String)
+			{
+				std::string_view string = value.GetString();
+				node.offset = AddString(string);
+				node.count = (u32)string.size();
+			}
+			else
+			{
+				values.resize(Align(values.size(), GetValueAlignment(value.type)));
+				node.offset = (u32)values.size();
+				values.insert(values.end(), value.data, value.data + value.size);
+			}
+			return Enter;
+		}
+
+		Action OnBeginStruct(u32 typeHash) override
+		{
+			Node& node = AddNode(GetNextType());
+			node.typeHash = typeHash;
+			m_frames.emplace_back();
+			return Enter;
+		}
+
+		Action OnEndStruct() override
+		{
+			EndFrame();
+			return Enter;
+		}
+
+		Action OnBeginContainer(BinType type, BinType elementType, u32 count) override
+		{
+			Node& node = AddNode(type);
+			node.elementType = elementType;
+
+			Frame frame;
+			frame.elementType = elementType;
+			if (GetBinTypeSize(elementType) != 0)
+			{
+				values.resize(Align(values.size(), SectionAlignment));
+				node.offset = (u32)values.size();
+				node.count = count;
+				frame.isTypedArray = true;
+			}
+
+			m_frames.push_back(std::move(frame));
+			return Enter;
+		}
+
+		Action OnEndContainer() override
+		{
+			if (m_frames.back().isTypedArray)
+				m_frames.pop_back();
+			else
+				EndFrame();
+			return Enter;
+		}
+
+		Action OnBeginMap(BinType keyType, BinType valueType, u32) override
+		{
+			Node& node = AddNode(BinType::Map);
+			node.elementType = keyType;
+			node.valueType = valueType;
+
+			Frame frame;
+			frame.elementType = keyType;
+			frame.valueType = valueType;
+			frame.isMap = true;
+			m_frames.push_back(std::move(frame));
+			return Enter;
+		}
+
+		Action OnEndMap() override
+		{
+			EndFrame();
+			return Enter;
+		}
+
+		// Adds the entries behind the other nodes, and sorts them by hash.
+		void Finish()
+		{
+			const std::vector<Node>& entryNodes = m_frames.front().children;
+			for (const Node& node : entryNodes)
+				entries.push_back({ node.nameHash, (u32)(nodes.size() + entries.size()) });
+			nodes.insert(nodes.end(), entryNodes.begin(), entryNodes.end());
+
+			std::stable_sort(entries.begin(), entries.end(), [](const Entry& left, const Entry& right) { return left.hash < right.hash; });
+		}
+
+		std::vector<LinkedFile> linkedFiles;
+		std::vector<Entry> entries;
+		std::vector<Node> nodes;
+		std::vector<u8> values;
+		std::string strings;
+
+	private:
+		struct Frame
+		{
+			std::vector<Node> children;
+			u32 fieldHash = 0;
+			BinType fieldType = BinType::Empty;	// Structs, the type of the field that comes next
+			BinType elementType = BinType::Empty;	// Containers, or the key type of maps
+			BinType valueType = BinType::Empty;		// Maps
+			bool isMap = false;
+			bool isTypedArray = false;
+		};
+
+		// Struct events don't tell if they're a struct or an embedded struct, but the field or container does.
+		BinType GetNextType() const
+		{
+			const Frame& frame = m_frames.back();
+			if (frame.fieldType != BinType::Empty)
+				return frame.fieldType;
+			if (frame.isMap && frame.children.size() % 2 == 1)
+				return frame.valueType;
+			return frame.elementType;
+		}
+
+		Node& AddNode(BinType type)
+		{
+			Frame& frame = m_frames.back();
+			Node node = {};
+			node.nameHash = frame.fieldHash;
+			node.type = type;
+			frame.fieldHash = 0;
+			frame.fieldType = BinType::Empty;
+
+			frame.children.push_back(node);
+			return frame.children.back();
+		}
+
+		void EndFrame()
+		{
+			Frame frame = std::move(m_frames.back());
+			m_frames.pop_back();
+
+			Node& parent = m_frames.back().children.back();
+			parent.offset = (u32)nodes.size();
+			parent.count = (u32)(frame.isMap ? frame.children.size() / 2 : frame.children.size());
+			nodes.insert(nodes.end(), frame.children.begin(), frame.children.end());
+		}
+
+		// Strings are pooled, as the same ones show up all over a bin.
+		u32 AddString(std::string_view string)
+		{
+			auto [index, isNew] = m_stringOffsets.try_emplace(std::string(string), (u32)strings.size());
+			if (isNew)
+				strings += string;
+			return index->second;
+		}
+
+		std::vector<Frame> m_frames;
+		std::unordered_map<std::string, u32> m_stringOffsets;
+	};
+
+	BinCacheNode::BinCacheNode(const BinCache& cache, const Node& node) :
+		m_cache(&cache), m_node(&node), m_type(node.type)
+	{
+		if (node.type == BinType::String)
+			m_data = reinterpret_cast<const u8*>(cache.m_strings + node.offset);
+		else if (GetBinTypeSize(node.type) != 0 || IsTypedArray())
+			m_data = cache.m_values + node.offset;
+	}
+
+	u32 BinCacheNode::GetNameHash() const
+	{
+		return m_node ? m_node->nameHash : 0;
+	}
+
+	u32 BinCacheNode::GetTypeHash() const
+	{
+		return m_node && IsStruct(m_type) ? m_node->typeHash : 0;
+	}
+
+	BinType BinCacheNode::GetElementType() const
+	{
+		return m_node ? m_node->elementType : BinType::Empty;
+	}
+
+	BinType BinCacheNode::GetValueType() const
+	{
+		return m_node ? m_node->valueType : BinType::Empty;
+	}
+
+	size_t BinCacheNode::size() const
+	{
+		if (m_node == nullptr || (IsStruct(m_type) == false && IsContainer(m_type) == false && m_type != BinType::Map))
+			return 0;
+		return m_node->count;
+	}
+
+	bool BinCacheNode::IsTypedArray() const
+	{
+		return m_node && IsContainer(m_type) && GetBinTypeSize(m_node->elementType) != 0;
+	}
+
+	BinCacheNode BinCacheNode::GetChild(size_t index) const
+	{
+		return BinCacheNode(*m_cache, m_cache->m_nodes[m_node->offset + index]);
+	}
+
+	BinCacheNode BinCacheNode::operator[](size_t index) const
+	{
+		if (IsContainer(m_type) == false || index >= size())
+			return BinCacheNode();
+
+		if (IsTypedArray())
+			return BinCacheNode(*m_cache, m_node->elementType, m_data + index * GetBinTypeSize(m_node->elementType));
+		return GetChild(index);
+	}
+
+	BinCacheNode BinCacheNode::operator[](std::string_view name) const
+	{
+		return operator[](BinFieldKey(HashName(name)));
+	}
+
+	BinCacheNode BinCacheNode::operator[](BinFieldKey key) const
+	{
+		if (IsStruct(m_type) == false)
+			return BinCacheNode();
+
+		for (size_t i = 0; i < size(); i++)
+			if (m_cache->m_nodes[m_node->offset + i].nameHash == key.hash)
+				return GetChild(i);
+		return BinCacheNode();
+	}
+
+	BinCacheNode BinCacheNode::GetField(size_t index) const
+	{
+		return IsStruct(m_type) && index < size() ? GetChild(index) : BinCacheNode();
+	}
+
+	BinCacheNode BinCacheNode::GetKey(size_t index) const
+	{
+		return m_type == BinType::Map && index < size() ? GetChild(index * 2) : BinCacheNode();
+	}
+
+	BinCacheNode BinCacheNode::GetValue(size_t index) const
+	{
+		return m_type == BinType::Map && index < size() ? GetChild(index * 2 + 1) : BinCacheNode();
+	}
+
+	BinCacheNode BinCacheNode::Find(u64 key) const
+	{
+		for (size_t i = 0; i < (m_type == BinType::Map ? size() : 0); i++)
+		{
+			BinCacheNode keyNode = GetKey(i);
+			u64 value = 0;
+			if (GetInteger(keyNode.m_type, keyNode.m_data, value) && value == key)
+				return GetValue(i);
+		}
+		return BinCacheNode();
+	}
+
+	BinCacheNode BinCacheNode::Find(std::string_view key) const
+	{
+		if (m_type != BinType::Map || GetKeyType() != BinType::String)
+			return BinCacheNode();
+
+		for (size_t i = 0; i < size(); i++)
+			if (GetKey(i).GetString() == key)
+				return GetValue(i);
+		return BinCacheNode();
+	}
+
+	std::string_view BinCacheNode::GetString() const
+	{
+		return m_type == BinType::String ? std::string_view(reinterpret_cast<const char*>(m_data), m_node->count) : std::string_view();
+	}
+
+	void BinCache::Reset()
+	{
+		m_buffer.clear();
+		m_file.Close();
+		m_data = nullptr;
+		m_size = 0;
+
+		m_header = nullptr;
+		m_linkedFiles = nullptr;
+		m_entries = nullptr;
+		m_nodes = nullptr;
+		m_values = nullptr;
+		m_strings = nullptr;
+	}
+
+	bool BinCache::Build(const u8* data, size_t size)
+	{
+		Reset();
+
+		Builder builder;
+		if (BinParser::Parse(data, size, builder) != BinParser::Result::Finished)
+			return false;
+		builder.Finish();
+
+		constexpr size_t maxSize = std::numeric_limits<u32>::max();
+		if (builder.nodes.size() > maxSize || builder.values.size() > maxSize || builder.strings.size() > maxSize)
+			return false;
+
+		Header header = {};
+		memcpy(header.magic, CacheMagic, sizeof(CacheMagic));
+		header.version = CacheVersion;
+		header.sourceChecksum = GetSourceChecksum(data, size);
+		memcpy(&header.binVersion, data + 4, sizeof(u32));
+		header.linkedFileCount = (u32)builder.linkedFiles.size();
+		header.entryCount = (u32)builder.entries.size();
+		header.nodeCount = (u32)builder.nodes.size();
+		header.valuesSize = (u32)builder.values.size();
+		header.stringsSize = (u32)builder.strings.size();
+
+		auto write = [this](size_t& offset, const void* source, size_t sourceSize)
+		{
+			offset = Align(offset, SectionAlignment);
+			m_buffer.resize(offset + sourceSize);
+			if (sourceSize != 0)
+				memcpy(m_buffer.data() + offset, source, sourceSize);
+			offset += sourceSize;
+		};
+
+		size_t offset = 0;
+		write(offset, &header, sizeof(Header));
+		write(offset, builder.linkedFiles.data(), builder.linkedFiles.size() * sizeof(LinkedFile));
+		write(offset, builder.entries.data(), builder.entries.size() * sizeof(Entry));
+		write(offset, builder.nodes.data(), builder.nodes.size() * sizeof(BinCacheNode::Node));
+		write(offset, builder.values.data(), builder.values.size());
+		write(offset, builder.strings.data(), builder.strings.size());
+
+		if (Map(m_buffer.data(), m_buffer.size()) == false)
+		{
+			Reset();
+			return false;
+		}
+		return true;
+	}
+
+	bool BinCache::Build(const Bin& bin)
+	{
+		if (bin.GetLoadState() != Spek::File::LoadState::Loaded)
+		{
+			Reset();
+			return false;
+		}
+
+		const std::vector<u8>& data = bin.GetFile()->GetData();
+		return Build(data.data(), data.size());
+	}
+
+	bool BinCache::Save(const std::string& path) const
+	{
+		if (IsValid() == false)
+			return false;
+
+		std::ofstream fileStream(path, std::ofstream::binary | std::ofstream::trunc);
+		if (!fileStream)
+			return false;
+
+		fileStream.write(reinterpret_cast<const char*>(m_data), m_size);
+		return fileStream.good();
+	}
+
+	bool BinCache::Load(const std::string& path)
+	{
+		Reset();
+		if (m_file.Open(path.c_str()) == false || Map(m_file.GetData(), m_file.GetSize()) == false)
+		{
+			Reset();
+			return false;
+		}
+		return true;
+	}
+
+	bool BinCache::Load(const std::string& path, u64 sourceChecksum)
+	{
+		if (Load(path) == false)
+			return false;
+
+		if (GetSourceChecksum() != sourceChecksum)
+		{
+			Reset();
+			return false;
+		}
+		return true;
+	}
+
+	bool BinCache::LoadOrBuild(const std::string& path, const u8* data, size_t size)
+	{
+		if (Load(path, GetSourceChecksum(data, size)))
+			return true;
+
+		if (Build(data, size) == false)
+			return false;
+
+		Save(path);
+		return true;
+	}
+
+	bool BinCache::LoadOrBuild(const std::string& path, const Bin& bin)
+	{
+		if (bin.GetLoadState() != Spek::File::LoadState::Loaded)
+		{
+			Reset();
+			return false;
+		}
+
+		const std::vector<u8>& data = bin.GetFile()->GetData();
+		return LoadOrBuild(path, data.data(), data.size());
+	}
+
+	bool BinCache::Map(const u8* data, size_t size)
+	{
+		using Node = BinCacheNode::Node;
+		static_assert(sizeof(Header) == 48 && sizeof(Node) == 20, "The cache is stored as it is");
+
+		if (size < sizeof(Header))
+			return false;
+
+		const Header& header = *reinterpret_cast<const Header*>(data);
+		if (memcmp(header.magic, CacheMagic, sizeof(CacheMagic)) != 0 || header.version != CacheVersion)
+			return false;
+
+		size_t offset = sizeof(Header);
+		auto section = [&offset](size_t sectionSize)
+		{
+			size_t start = Align(offset, SectionAlignment);
+			offset = start + sectionSize;
+			return start;
+		};
+
+		size_t linkedFilesOffset = section((size_t)header.linkedFileCount * sizeof(LinkedFile));
+		size_t entriesOffset = section((size_t)header.entryCount * sizeof(Entry));
+		size_t nodesOffset = section((size_t)header.nodeCount * sizeof(Node));
+		size_t valuesOffset = section(header.valuesSize);
+		size_t stringsOffset = section(header.stringsSize);
+		if (offset != size)
+			return false;
+
+		const LinkedFile* linkedFiles = reinterpret_cast<const LinkedFile*>(data + linkedFilesOffset);
+		const Entry* entries = reinterpret_cast<const Entry*>(data + entriesOffset);
+		const Node* nodes = reinterpret_cast<const Node*>(data + nodesOffset);
+
+		// Everything the nodes point to has to be inside of the cache, which is all that's checked.
+		for (u32 i = 0; i < header.linkedFileCount; i++)
+			if ((u64)linkedFiles[i].offset + linkedFiles[i].length > header.stringsSize)
+				return false;
+
+		for (u32 i = 0; i < header.entryCount; i++)
+			if (entries[i].node >= header.nodeCount || (i > 0 && entries[i - 1].hash > entries[i].hash))
+				return false;
+
+		for (u32 i = 0; i < header.nodeCount; i++)
+		{
+			const Node& node = nodes[i];
+			size_t elementSize = GetBinTypeSize(node.elementType);
+
+			bool isValid;
+			if (node.type == BinType::String)
+				isValid = (u64)node.offset + node.count <= header.stringsSize;
+			else if (IsContainer(node.type) && elementSize != 0)
+				isValid = node.offset % SectionAlignment == 0 && (u64)node.offset + (u64)node.count * elementSize <= header.valuesSize;
+			else if (IsStruct(node.type) || IsContainer(node.type))
+				isValid = (u64)node.offset + node.count <= header.nodeCount;
+			else if (node.type == BinType::Map)
+				isValid = (u64)node.offset + (u64)node.count * 2 <= header.nodeCount;
+			else
+				isValid = GetBinTypeSize(node.type) != 0 && node.offset % GetValueAlignment(node.type) == 0 && (u64)node.offset + GetBinTypeSize(node.type) <= header.valuesSize;
+
+			if (isValid == false)
+				return false;
+		}
+
+		m_data = data;
+		m_size = size;
+		m_header = &header;
+		m_linkedFiles = linkedFiles;
+		m_entries = entries;
+		m_nodes = nodes;
+		m_values = data + valuesOffset;
+		m_strings = reinterpret_cast<const char*>(data + stringsOffset);
+		return true;
+	}
+
+	u64 BinCache::GetSourceChecksum() const
+	{
+		return IsValid() ? m_header->sourceChecksum : 0;
+	}
+
+	u32 BinCache::GetVersion() const
+	{
+		return IsValid() ? m_header->binVersion : 0;
+	}
+
+	size_t BinCache::GetLinkedFileCount() const
+	{
+		return IsValid() ? m_header->linkedFileCount : 0;
+	}
+
+	std::string_view BinCache::GetLinkedFile(size_t index) const
+	{
+		if (index >= GetLinkedFileCount())
+			return std::string_view();
+		return std::string_view(m_strings + m_linkedFiles[index].offset, m_linkedFiles[index].length);
+	}
+
+	size_t BinCache::size() const
+	{
+		return IsValid() ? m_header->entryCount : 0;
+	}
+
+	BinCacheNode BinCache::GetEntry(size_t index) const
+	{
+		return index < size() ? BinCacheNode(*this, m_nodes[m_entries[index].node]) : BinCacheNode();
+	}
+
+	BinCacheNode BinCache::operator[](u32 hash) const
+	{
+		const Entry* end = m_entries + size();
+		const Entry* entry = std::lower_bound(m_entries, end, hash, [](const Entry& left, u32 right) { return left.hash < right; });
+		return entry != end && entry->hash == hash ? BinCacheNode(*this, m_nodes[entry->node]) : BinCacheNode();
+	}
+
+	BinCacheNode BinCache::operator[](std::string_view name) const
+	{
+		return operator[](HashName(name));
+	}
+}
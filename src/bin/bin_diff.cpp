@@ -0,0 +1,545 @@
+#include <league_lib/bin/bin_diff.hpp>
+#include <league_lib/util/thread_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace LeagueLib
+{
+	using Step = BinDiff::Step;
+	using Change = BinDiff::Change;
+
+	template<typename T>
+	static bool Read(const u8* data, size_t size, size_t& offset, T& value)
+	{
+		if (offset + sizeof(T) > size)
+			return false;
+
+		memcpy(&value, data + offset, sizeof(T));
+		offset += sizeof(T);
+		return true;
+	}
+
+	// A value in one of the files, from its first byte up to end.
+	struct Value
+	{
+		const u8* data;
+		size_t offset;
+		size_t end;
+		BinType type;
+
+		BinValueView GetView() const { return { type, data + offset, end - offset }; }
+		std::string_view GetBytes() const { return std::string_view((const char*)data + offset, end - offset); }
+	};
+
+	struct Field
+	{
+		u32 hash;
+		Value value;
+	};
+
+	// Tracks the path of the value being compared, and collects the changes of one entry.
+	struct DiffContext
+	{
+		u32 entryHash;
+		std::vector<Step> path;
+		std::vector<Change>& changes;
+
+		bool isMalformed = false;
+
+		void Add(Change::Kind kind, const Value* oldValue, const Value* newValue)
+		{
+			Change change = { kind, entryHash, path };
+			if (oldValue)
+				change.oldValue = oldValue->GetView();
+			if (newValue)
+				change.newValue = newValue->GetView();
+			changes.push_back(std::move(change));
+		}
+	};
+
+	static void DiffValue(const Value& oldValue, const Value& newValue, DiffContext& context);
+
+	static bool ReadFields(const u8* data, size_t end, size_t offset, u16 count, std::vector<Field>& fields)
+	{
+		fields.reserve(count);
+		for (u16 i = 0; i < count; i++)
+		{
+			Field field;
+			if (Read(data, end, offset, field.hash) == false || Read(data, end, offset, field.value.type) == false)
+				return false;
+
+			field.value.data = data;
+			field.value.offset = offset;
+			if (BinParser::SkipValue(data, end, offset, field.value.type) == false)
+				return false;
+
+			field.value.end = offset;
+			fields.push_back(field);
+		}
+		return true;
+	}
+
+	static bool ReadElements(const u8* data, size_t end, size_t offset, BinType type, u32 count, std::vector<Value>& elements)
+	{
+		elements.reserve(count);
+		for (u32 i = 0; i < count; i++)
+		{
+			Value element = { data, offset, 0, type };
+			if (BinParser::SkipValue(data, end, offset, type) == false)
+				return false;
+
+			element.end = offset;
+			elements.push_back(element);
+		}
+		return true;
+	}
+
+	// Fields are matched by name. Removed fields come after the fields of the new value.
+	static void DiffFields(const std::vector<Field>& oldFields, const std::vector<Field>& newFields, DiffContext& context)
+	{
+		auto find = [](const std::vector<Field>& fields, u32 hash) -> const Field*
+		{
+			for (const Field& field : fields)
+				if (field.hash == hash)
+					return &field;
+			return nullptr;
+		};
+
+		for (const Field& newField : newFields)
+		{
+			context.path.push_back({ Step::Kind::Field, newField.hash });
+			if (const Field* oldField = find(oldFields, newField.hash))
+				DiffValue(oldField->value, newField.value, context);
+			else
+				context.Add(Change::Kind::Added, nullptr, &newField.value);
+			context.path.pop_back();
+		}
+
+		for (const Field& oldField : oldFields)
+		{
+			if (find(newFields, oldField.hash))
+				continue;
+
+			context.path.push_back({ Step::Kind::Field, oldField.hash });
+			context.Add(Change::Kind::Removed, &oldField.value, nullptr);
+			context.path.pop_back();
+		}
+	}
+
+	static void DiffStructs(const Value& oldValue, const Value& newValue, DiffContext& context)
+	{
+		size_t oldOffset = oldValue.offset;
+		size_t newOffset = newValue.offset;
+		u32 oldTypeHash, newTypeHash;
+		if (Read(oldValue.data, oldValue.end, oldOffset, oldTypeHash) == false || Read(newValue.data, newValue.end, newOffset, newTypeHash) == false)
+		{
+			context.isMalformed = true;
+			return;
+		}
+
+		// A struct that is another class, or null on one side, has changed as a whole.
+		if (oldTypeHash != newTypeHash || oldTypeHash == 0)
+		{
+			context.Add(Change::Kind::Modified, &oldValue, &newValue);
+			return;
+		}
+
+		oldOffset += sizeof(u32); // Length
+		newOffset += sizeof(u32);
+
+		u16 oldCount, newCount;
+		std::vector<Field> oldFields, newFields;
+		if (Read(oldValue.data, oldValue.end, oldOffset, oldCount) == false || Read(newValue.data, newValue.end, newOffset, newCount) == false ||
+			ReadFields(oldValue.data, oldValue.end, oldOffset, oldCount, oldFields) == false || ReadFields(newValue.data, newValue.end, newOffset, newCount, newFields) == false)
+		{
+			context.isMalformed = true;
+			return;
+		}
+
+		DiffFields(oldFields, newFields, context);
+	}
+
+	// Elements are matched by index, so inserting an element shows up as every element after it changing.
+	static void DiffContainers(const Value& oldValue, const Value& newValue, DiffContext& context)
+	{
+		size_t oldOffset = oldValue.offset;
+		size_t newOffset = newValue.offset;
+		BinType oldElementType, newElementType;
+		if (Read(oldValue.data, oldValue.end, oldOffset, oldElementType) == false || Read(newValue.data, newValue.end, newOffset, newElementType) == false)
+		{
+			context.isMalformed = true;
+			return;
+		}
+
+		if (oldElementType != newElementType)
+		{
+			context.Add(Change::Kind::Modified, &oldValue, &newValue);
+			return;
+		}
+
+		u32 oldCount = 0, newCount = 0;
+		bool isRead;
+		if (oldValue.type == BinType::Array)
+		{
+			u8 oldArrayCount = 0, newArrayCount = 0;
+			isRead = Read(oldValue.data, oldValue.end, oldOffset, oldArrayCount) && Read(newValue.data, newValue.end, newOffset, newArrayCount);
+			oldCount = oldArrayCount;
+			newCount = newArrayCount;
+		}
+		else
+		{
+			oldOffset += sizeof(u32); // Length
+			newOffset += sizeof(u32);
+			isRead = Read(oldValue.data, oldValue.end, oldOffset, oldCount) && Read(newValue.data, newValue.end, newOffset, newCount);
+		}
+
+		std::vector<Value> oldElements, newElements;
+		if (isRead == false || ReadElements(oldValue.data, oldValue.end, oldOffset, oldElementType, oldCount, oldElements) == false ||
+			ReadElements(newValue.data, newValue.end, newOffset, newElementType, newCount, newElements) == false)
+		{
+			context.isMalformed = true;
+			return;
+		}
+
+		size_t count = std::max(oldElements.size(), newElements.size());
+		for (size_t i = 0; i < count; i++)
+		{
+			context.path.push_back({ Step::Kind::Index, 0, (u32)i });
+			if (i >= oldElements.size())
+				context.Add(Change::Kind::Added, nullptr, &newElements[i]);
+			else if (i >= newElements.size())
+				context.Add(Change::Kind::Removed, &oldElements[i], nullptr);
+			else
+				DiffValue(oldElements[i], newElements[i], context);
+			context.path.pop_back();
+		}
+	}
+
+	// Pairs are matched by the bytes of their key, which is exact for the key types maps use.
+	static void DiffMaps(const Value& oldValue, const Value& newValue, DiffContext& context)
+	{
+		size_t oldOffset = oldValue.offset;
+		size_t newOffset = newValue.offset;
+		BinType oldKeyType, oldValueType, newKeyType, newValueType;
+		if (Read(oldValue.data, oldValue.end, oldOffset, oldKeyType) == false || Read(oldValue.data, oldValue.end, oldOffset, oldValueType) == false ||
+			Read(newValue.data, newValue.end, newOffset, newKeyType) == false || Read(newValue.data, newValue.end, newOffset, newValueType) == false)
+		{
+			context.isMalformed = true;
+			return;
+		}
+
+		if (oldKeyType != newKeyType || oldValueType != newValueType)
+		{
+			context.Add(Change::Kind::Modified, &oldValue, &newValue);
+			return;
+		}
+
+		oldOffset += sizeof(u32); // Length
+		newOffset += sizeof(u32);
+
+		u32 oldCount, newCount;
+		if (Read(oldValue.data, oldValue.end, oldOffset, oldCount) == false || Read(newValue.data, newValue.end, newOffset, newCount) == false)
+		{
+			context.isMalformed = true;
+			return;
+		}
+
+		auto readPairs = [oldKeyType, oldValueType](const Value& map, size_t offset, u32 count, std::vector<std::pair<Value, Value>>& pairs)
+		{
+			pairs.reserve(count);
+			for (u32 i = 0; i < count; i++)
+			{
+				Value key = { map.data, offset, 0, oldKeyType };
+				if (BinParser::SkipValue(map.data, map.end, offset, oldKeyType) == false)
+					return false;
+				key.end = offset;
+
+				Value value = { map.data, offset, 0, oldValueType };
+				if (BinParser::SkipValue(map.data, map.end, offset, oldValueType) == false)
+					return false;
+				value.end = offset;
+
+				pairs.emplace_back(key, value);
+			}
+			return true;
+		};
+
+		std::vector<std::pair<Value, Value>> oldPairs, newPairs;
+		if (readPairs(oldValue, oldOffset, oldCount, oldPairs) == false || readPairs(newValue, newOffset, newCount, newPairs) == false)
+		{
+			context.isMalformed = true;
+			return;
+		}
+
+		std::unordered_map<std::string_view, size_t> oldIndices;
+		oldIndices.reserve(oldPairs.size());
+		for (size_t i = 0; i < oldPairs.size(); i++)
+			oldIndices.emplace(oldPairs[i].first.GetBytes(), i);
+
+		std::unordered_set<std::string_view> newKeys;
+		newKeys.reserve(newPairs.size());
+		for (const auto& [newKey, newPairValue] : newPairs)
+		{
+			newKeys.insert(newKey.GetBytes());
+			context.path.push_back({ Step::Kind::Key, 0, 0, newKey.GetView() });
+
+			auto oldIndex = oldIndices.find(newKey.GetBytes());
+			if (oldIndex != oldIndices.end())
+				DiffValue(oldPairs[oldIndex->second].second, newPairValue, context);
+			else
+				context.Add(Change::Kind::Added, nullptr, &newPairValue);
+			context.path.pop_back();
+		}
+
+		for (const auto& [oldKey, oldPairValue] : oldPairs)
+		{
+			if (newKeys.find(oldKey.GetBytes()) != newKeys.end())
+				continue;
+
+			context.path.push_back({ Step::Kind::Key, 0, 0, oldKey.GetView() });
+			context.Add(Change::Kind::Removed, &oldPairValue, nullptr);
+			context.path.pop_back();
+		}
+	}
+
+	static void DiffValue(const Value& oldValue, const Value& newValue, DiffContext& context)
+	{
+		if (oldValue.type != newValue.type)
+		{
+			context.Add(Change::Kind::Modified, &oldValue, &newValue);
+			return;
+		}
+
+		// Values that are the same byte for byte are skipped without looking inside of them.
+		if (oldValue.GetBytes() == newValue.GetBytes())
+			return;
+
+		switch (oldValue.type)
+		{
+		case BinType::Struct:
+		case BinType::Embedded:
+			DiffStructs(oldValue, newValue, context);
+			break;
+
+		case BinType::Container:
+		case BinType::Container2:
+		case BinType::Array:
+			DiffContainers(oldValue, newValue, context);
+			break;
+
+		case BinType::Map:
+			DiffMaps(oldValue, newValue, context);
+			break;
+
+		default:
+			context.Add(Change::Kind::Modified, &oldValue, &newValue);
+			break;
+		}
+	}
+
+	// Entries are given as an embedded struct, from their hash up to their end.
+	static Value GetEntryValue(const u8* data, const Bin::Entry& entry)
+	{
+		return { data, entry.offset, entry.offset + entry.length, BinType::Embedded };
+	}
+
+	static bool DiffEntry(const u8* oldData, const Bin::Entry& oldEntry, const u8* newData, const Bin::Entry& newEntry, std::vector<Change>& changes)
+	{
+		Value oldValue = GetEntryValue(oldData, oldEntry);
+		Value newValue = GetEntryValue(newData, newEntry);
+		DiffContext context = { newEntry.hash, {}, changes };
+
+		// The class of an entry is in the type array, so it isn't part of its bytes.
+		if (oldEntry.typeHash != newEntry.typeHash)
+		{
+			context.Add(Change::Kind::Modified, &oldValue, &newValue);
+			return true;
+		}
+
+		if (oldValue.GetBytes() == newValue.GetBytes())
+			return true;
+
+		size_t oldOffset = oldEntry.offset + sizeof(u32); // Hash
+		size_t newOffset = newEntry.offset + sizeof(u32);
+
+		u16 oldCount, newCount;
+		std::vector<Field> oldFields, newFields;
+		if (Read(oldData, oldValue.end, oldOffset, oldCount) == false || Read(newData, newValue.end, newOffset, newCount) == false ||
+			ReadFields(oldData, oldValue.end, oldOffset, oldCount, oldFields) == false || ReadFields(newData, newValue.end, newOffset, newCount, newFields) == false)
+			return false;
+
+		DiffFields(oldFields, newFields, context);
+		return context.isMalformed == false;
+	}
+
+	bool BinDiff::Diff(const u8* oldData, size_t oldSize, const u8* newData, size_t newSize, std::vector<Change>& changes)
+	{
+		Bin::Header oldHeader, newHeader;
+		if ((oldSize != 0 && Bin::ReadHeader(oldData, oldSize, oldHeader) == false) || (newSize != 0 && Bin::ReadHeader(newData, newSize, newHeader) == false))
+			return false;
+
+		// Entries that share a hash are found as the first one, like Bin does, so that's the only one that is compared.
+		std::unordered_map<u32, size_t> oldIndices;
+		oldIndices.reserve(oldHeader.entries.size());
+		for (size_t i = 0; i < oldHeader.entries.size(); i++)
+			oldIndices.emplace(oldHeader.entries[i].hash, i);
+
+		std::vector<const Bin::Entry*> newEntries;
+		std::unordered_set<u32> newHashes;
+		for (const Bin::Entry& entry : newHeader.entries)
+			if (newHashes.insert(entry.hash).second)
+				newEntries.push_back(&entry);
+
+		// Every entry gets its own list, so they can be compared in parallel and still end up in order.
+		std::vector<std::vector<Change>> entryChanges(newEntries.size());
+		std::atomic<bool> isMalformed = false;
+		ThreadPool::GetDefault().ParallelFor(newEntries.size(), 64, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				const Bin::Entry& newEntry = *newEntries[i];
+				auto oldIndex = oldIndices.find(newEntry.hash);
+				if (oldIndex == oldIndices.end())
+				{
+					Value newValue = GetEntryValue(newData, newEntry);
+					DiffContext context = { newEntry.hash, {}, entryChanges[i] };
+					context.Add(Change::Kind::Added, nullptr, &newValue);
+				}
+				else if (DiffEntry(oldData, oldHeader.entries[oldIndex->second], newData, newEntry, entryChanges[i]) == false)
+				{
+					isMalformed = true;
+				}
+			}
+		});
+
+		if (isMalformed)
+			return false;
+
+		for (std::vector<Change>& entry : entryChanges)
+			changes.insert(changes.end(), std::make_move_iterator(entry.begin()), std::make_move_iterator(entry.end()));
+
+		for (size_t i = 0; i < oldHeader.entries.size(); i++)
+		{
+			const Bin::Entry& oldEntry = oldHeader.entries[i];
+			if (oldIndices[oldEntry.hash] != i || newHashes.find(oldEntry.hash) != newHashes.end())
+				continue;
+
+			Value oldValue = GetEntryValue(oldData, oldEntry);
+			DiffContext context = { oldEntry.hash, {}, changes };
+			context.Add(Change::Kind::Removed, &oldValue, nullptr);
+		}
+
+		return true;
+	}
+
+	bool BinDiff::Diff(const Bin& oldBin, const Bin& newBin, std::vector<Change>& changes)
+	{
+		if (oldBin.GetLoadState() != Spek::File::LoadState::Loaded || newBin.GetLoadState() != Spek::File::LoadState::Loaded)
+			return false;
+
+		const std::vector<u8>& oldData = oldBin.GetFile()->GetData();
+		const std::vector<u8>& newData = newBin.GetFile()->GetData();
+		return Diff(oldData.data(), oldData.size(), newData.data(), newData.size(), changes);
+	}
+
+	size_t BinDiff::Diff(const std::vector<const WAD*>& oldArchives, const std::vector<const WAD*>& newArchives, const OnFileFunction& onFile, const FileFilterFunction& filter)
+	{
+		BinArchiveFiles files(oldArchives, newArchives, filter);
+		return files.ForEach([&onFile](const BinArchiveFiles::File& file, const std::vector<u8> (&data)[2])
+		{
+			thread_local std::vector<Change> changes;
+			changes.clear();
+			if (Diff(data[0].data(), data[0].size(), data[1].data(), data[1].size(), changes) == false || changes.empty())
+				return false;
+
+			if (onFile)
+				onFile(file.hash, changes);
+			return true;
+		});
+	}
+
+	size_t BinDiff::Diff(const WADFileSystem& oldFileSystem, const WADFileSystem& newFileSystem, const OnFileFunction& onFile, const FileFilterFunction& filter)
+	{
+		return Diff(BinArchiveFiles::GetArchives(oldFileSystem), BinArchiveFiles::GetArchives(newFileSystem), onFile, filter);
+	}
+
+	std::string BinDiff::GetPath(const Change& change)
+	{
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), "0x%08x", change.entryHash);
+		std::string result = buffer;
+
+		for (const Step& step : change.path)
+		{
+			switch (step.kind)
+			{
+			case Step::Kind::Field:
+				snprintf(buffer, sizeof(buffer), ".0x%08x", step.hash);
+				break;
+
+			case Step::Kind::Index:
+				snprintf(buffer, sizeof(buffer), "[%u]", step.index);
+				break;
+
+			case Step::Kind::Key:
+			{
+				if (step.key.type == BinType::String)
+				{
+					// Escaped the way BinQuery::Compile reads them.
+					result += "{\"";
+					for (char character : step.key.GetString())
+					{
+						if (character == '"' || character == '\\')
+							result += '\\';
+						result += character;
+					}
+					result += "\"}";
+					continue;
+				}
+
+				// Signed keys are written the way BinQuery compares them, as their value cast to u64.
+				u64 key;
+				switch (step.key.type)
+				{
+				case BinType::Bool:
+				case BinType::Flag:
+				case BinType::U8:	key = step.key.Get<u8>(); break;
+				case BinType::S8:	key = (u64)step.key.Get<i8>(); break;
+				case BinType::S16:	key = (u64)step.key.Get<i16>(); break;
+				case BinType::U16:	key = step.key.Get<u16>(); break;
+				case BinType::S32:	key = (u64)step.key.Get<i32>(); break;
+				case BinType::S64:	key = (u64)step.key.Get<i64>(); break;
+				case BinType::U32:	key = step.key.Get<u32>(); break;
+				case BinType::U64:	key = step.key.Get<u64>(); break;
+
+				case BinType::Hash:
+				case BinType::Link:
+					snprintf(buffer, sizeof(buffer), "{0x%08x}", step.key.Get<u32>());
+					result += buffer;
+					continue;
+
+				case BinType::Path:
+					snprintf(buffer, sizeof(buffer), "{0x%016llx}", (unsigned long long)step.key.Get<u64>());
+					result += buffer;
+					continue;
+
+				default:
+					result += "{?}";
+					continue;
+				}
+
+				snprintf(buffer, sizeof(buffer), "{%llu}", (unsigned long long)key);
+				break;
+			}
+			}
+
+			result += buffer;
+		}
+
+		return result;
+	}
+}
@@ -0,0 +1,183 @@
+#include <league_lib/bin/bin_graph.hpp>
+#include <league_lib/util/hash.hpp>
+#include <league_lib/util/thread_pool.hpp>
+
+#include <algorithm>
+#include <cctype>
+
+namespace LeagueLib
+{
+	using namespace Spek;
+
+	// Linked files don't always use the same case, but they're all the same file.
+	static std::string GetNodeKey(std::string_view path)
+	{
+		std::string key(path);
+		std::transform(key.begin(), key.end(), key.begin(), [](char c) { return (char)tolower(c); });
+		return key;
+	}
+
+	BinGraph::~BinGraph()
+	{
+		Reset();
+	}
+
+	void BinGraph::Load(const std::string& path, OnLoadFunction onLoad, u32 loadFlags, u32 binLoadFlags)
+	{
+		Load(std::vector<std::string>{ path }, onLoad, loadFlags, binLoadFlags);
+	}
+
+	void BinGraph::Load(const std::vector<std::string>& paths, OnLoadFunction onLoad, u32 loadFlags, u32 binLoadFlags)
+	{
+		Reset();
+		m_onLoad = onLoad;
+		m_loadFlags = loadFlags;
+		m_binLoadFlags = binLoadFlags;
+
+		// All of the requested bins are added before any of them load, so they come first.
+		std::vector<std::shared_ptr<Node>> roots;
+		for (const std::string& path : paths)
+			if (std::shared_ptr<Node> node = AddNode(path))
+				roots.push_back(node);
+		m_rootCount = m_nodes.size();
+
+		// Bins can load right away, so hold on to a request of our own until all of them are out.
+		m_pendingCount++;
+		for (const std::shared_ptr<Node>& node : roots)
+			StartLoad(node);
+
+		if (--m_pendingCount == 0)
+			Finish();
+	}
+
+	std::shared_ptr<BinGraph::Node> BinGraph::AddNode(const std::string& path)
+	{
+		std::string key = GetNodeKey(path);
+		if (m_nodeIndices.find(key) != m_nodeIndices.end())
+			return nullptr;
+
+		m_nodeIndices.emplace(key, m_nodes.size());
+		m_nodes.push_back(std::make_shared<Node>());
+		m_nodes.back()->path = path;
+		m_nodes.back()->graph = this;
+		return m_nodes.back();
+	}
+
+	void BinGraph::StartLoad(const std::shared_ptr<Node>& node)
+	{
+		m_pendingCount++;
+		node->bin.Load(node->path, [node](Bin&)
+		{
+			if (node->graph)
+				node->graph->OnBinLoaded(*node);
+		}, m_binLoadFlags);
+	}
+
+	void BinGraph::OnBinLoaded(Node& node)
+	{
+		// The bin calls this again when its file is reloaded, which the graph doesn't track.
+		if (node.isResolved)
+			return;
+		node.isResolved = true;
+
+		if (node.bin.GetLoadState() == File::LoadState::Loaded)
+		{
+			for (const std::string& linkedFile : node.bin.GetLinkedFiles())
+				if (std::shared_ptr<Node> linkedNode = AddNode(linkedFile))
+					StartLoad(linkedNode);
+		}
+		else
+		{
+			m_failedFiles.push_back(node.path);
+		}
+
+		if (--m_pendingCount == 0)
+			Finish();
+	}
+
+	void BinGraph::Finish()
+	{
+		if (m_loadFlags & ParseBins)
+		{
+			ThreadPool::GetDefault().ParallelFor(m_nodes.size(), 1, [this](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+					if (m_nodes[i]->bin.GetLoadState() == File::LoadState::Loaded)
+						m_nodes[i]->bin.ParseAll();
+			});
+		}
+
+		// Earlier bins win, which are the requested ones and the ones closest to them.
+		for (size_t i = 0; i < m_nodes.size(); i++)
+			if (m_nodes[i]->bin.GetLoadState() == File::LoadState::Loaded)
+				for (const Bin::Entry& entry : m_nodes[i]->bin.GetEntries())
+					m_entryOwners.emplace(entry.hash, i);
+
+		m_loadState = File::LoadState::Loaded;
+		for (size_t i = 0; i < m_rootCount; i++)
+			if (m_nodes[i]->bin.GetLoadState() != File::LoadState::Loaded)
+				m_loadState = File::LoadState::FailedToLoad;
+
+		// onLoad might load or reset the graph again, which replaces m_onLoad.
+		OnLoadFunction onLoad = m_onLoad;
+		if (onLoad)
+			onLoad(*this);
+	}
+
+	std::vector<const Bin*> BinGraph::GetBins() const
+	{
+		std::vector<const Bin*> result;
+		result.reserve(m_nodes.size());
+		for (const auto& node : m_nodes)
+			result.push_back(&node->bin);
+		return result;
+	}
+
+	const Bin* BinGraph::GetBin(std::string_view path) const
+	{
+		auto index = m_nodeIndices.find(GetNodeKey(path));
+		return index != m_nodeIndices.end() ? &m_nodes[index->second]->bin : nullptr;
+	}
+
+	const Bin* BinGraph::FindBin(u32 hash) const
+	{
+		auto owner = m_entryOwners.find(hash);
+		return owner != m_entryOwners.end() ? &m_nodes[owner->second]->bin : nullptr;
+	}
+
+	const BinVariable& BinGraph::operator[](u32 hash) const
+	{
+		static const BinVariable none;
+		const Bin* bin = FindBin(hash);
+		return bin ? (*bin)[hash] : none;
+	}
+
+	const BinVariable& BinGraph::operator[](std::string_view name) const
+	{
+		return operator[](HashName(name));
+	}
+
+	const BinVariable& BinGraph::operator[](BinFieldKey key) const
+	{
+		return operator[](key.hash);
+	}
+
+	void BinGraph::Reset()
+	{
+		// The files keep the callbacks and with them the nodes, so their bins are reset to let go of what they hold.
+		for (const std::shared_ptr<Node>& node : m_nodes)
+		{
+			node->graph = nullptr;
+			node->bin.Reset();
+		}
+
+		m_nodes.clear();
+		m_nodeIndices.clear();
+		m_entryOwners.clear();
+		m_failedFiles.clear();
+		m_rootCount = 0;
+		m_pendingCount = 0;
+		m_onLoad = nullptr;
+		m_loadState = File::LoadState::NotLoaded;
+	}
+}
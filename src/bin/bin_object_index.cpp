@@ -0,0 +1,264 @@
+#include <league_lib/bin/bin_object_index.hpp>
+#include <league_lib/bin/bin_type_scan.hpp>
+#include <league_lib/wad/wad_filesystem.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+
+namespace LeagueLib
+{
+	// Layout of the index: the header, the archives, the locations sorted by root hash, the hash table of slots and
+	// finally the archive names. Slots hold the index of a location plus one, or 0 if they're empty.
+	struct BinObjectIndex::Header
+	{
+		char magic[4];
+		u32 version;
+		u32 archiveCount;
+		u32 locationCount;
+		u32 slotCount;
+		u32 namesSize;
+	};
+
+	struct BinObjectIndex::Archive
+	{
+		u64 checksum;
+		u32 nameOffset;
+		u32 nameLength;
+	};
+
+	static constexpr char IndexMagic[4] = { 'B', 'O', 'I', 'X' };
+	static constexpr u32 IndexVersion = 1;
+
+	static_assert(sizeof(BinObjectIndex::Location) == 32, "Locations are stored as they are");
+
+	const BinObjectIndex::Header& BinObjectIndex::GetHeader() const
+	{
+		return *reinterpret_cast<const Header*>(m_data);
+	}
+
+	const BinObjectIndex::Archive* BinObjectIndex::GetArchives() const
+	{
+		return reinterpret_cast<const Archive*>(m_data + sizeof(Header));
+	}
+
+	const BinObjectIndex::Location* BinObjectIndex::GetLocations() const
+	{
+		return reinterpret_cast<const Location*>(GetArchives() + GetHeader().archiveCount);
+	}
+
+	const u32* BinObjectIndex::GetSlots() const
+	{
+		return reinterpret_cast<const u32*>(GetLocations() + GetHeader().locationCount);
+	}
+
+	void BinObjectIndex::Reset()
+	{
+		m_buffer.clear();
+		m_file.Close();
+		m_data = nullptr;
+		m_size = 0;
+		m_archives.clear();
+	}
+
+	void BinObjectIndex::Build(const std::vector<const WAD*>& archives)
+	{
+		Reset();
+
+		std::unordered_map<const WAD*, u32> archiveIndices;
+		for (u32 i = 0; i < archives.size(); i++)
+			archiveIndices.emplace(archives[i], i);
+
+		std::mutex mutex;
+		std::vector<Location> locations;
+		BinTypeScan().Scan(archives, [&archiveIndices, &mutex, &locations](const BinTypeScan::Match& match)
+		{
+			Location location = { match.fileHash, match.entry.hash, match.entry.typeHash, (u32)match.entry.offset, match.entry.length, archiveIndices.at(match.archive), 0 };
+
+			std::lock_guard lock(mutex);
+			locations.push_back(location);
+		});
+
+		// Sorting makes the index the same no matter how the scan was scheduled, and puts the first archive first.
+		std::sort(locations.begin(), locations.end(), [](const Location& left, const Location& right)
+		{
+			return std::tie(left.rootHash, left.archiveIndex, left.pathHash, left.entryOffset) < std::tie(right.rootHash, right.archiveIndex, right.pathHash, right.entryOffset);
+		});
+
+		// Keep the table at most half full. Root hashes are FNV hashes already, so they're used as they are.
+		u32 slotCount = 16;
+		while (slotCount < locations.size() * 2)
+			slotCount *= 2;
+
+		std::string names;
+		std::vector<Archive> archiveRecords;
+		for (const WAD* archive : archives)
+		{
+			std::string name = archive->GetFileName();
+			archiveRecords.push_back({ archive->GetChecksum(), (u32)names.size(), (u32)name.size() });
+			names += name;
+		}
+
+		Header header = { { IndexMagic[0], IndexMagic[1], IndexMagic[2], IndexMagic[3] }, IndexVersion, (u32)archives.size(), (u32)locations.size(), slotCount, (u32)names.size() };
+		m_buffer.resize(sizeof(Header) + archiveRecords.size() * sizeof(Archive) + locations.size() * sizeof(Location) + slotCount * sizeof(u32) + names.size());
+
+		u8* output = m_buffer.data();
+		memcpy(output, &header, sizeof(Header));											output += sizeof(Header);
+		memcpy(output, archiveRecords.data(), archiveRecords.size() * sizeof(Archive));	output += archiveRecords.size() * sizeof(Archive);
+		memcpy(output, locations.data(), locations.size() * sizeof(Location));				output += locations.size() * sizeof(Location);
+
+		u32* slots = reinterpret_cast<u32*>(output);
+		for (u32 i = 0; i < locations.size(); i++)
+		{
+			u32 slot = locations[i].rootHash & (slotCount - 1);
+			while (slots[slot] != 0)
+				slot = (slot + 1) & (slotCount - 1);
+			slots[slot] = i + 1;
+		}
+		output += slotCount * sizeof(u32);
+
+		memcpy(output, names.data(), names.size());
+
+		m_data = m_buffer.data();
+		m_size = m_buffer.size();
+		m_archives = archives;
+	}
+
+	void BinObjectIndex::Build(const WADFileSystem& fileSystem)
+	{
+		std::vector<const WAD*> archives;
+		for (const auto& archive : fileSystem.GetArchives())
+			archives.push_back(archive.get());
+		Build(archives);
+	}
+
+	bool BinObjectIndex::Save(const std::string& path) const
+	{
+		if (IsValid() == false)
+			return false;
+
+		std::ofstream fileStream(path, std::ofstream::binary | std::ofstream::trunc);
+		if (!fileStream)
+			return false;
+
+		fileStream.write(reinterpret_cast<const char*>(m_data), m_size);
+		return fileStream.good();
+	}
+
+	bool BinObjectIndex::Load(const std::string& path, const std::vector<const WAD*>& archives)
+	{
+		Reset();
+		if (m_file.Open(path.c_str()) == false)
+			return false;
+
+		m_data = m_file.GetData();
+		m_size = m_file.GetSize();
+		if (Validate(archives) == false)
+		{
+			Reset();
+			return false;
+		}
+
+		m_archives = archives;
+		return true;
+	}
+
+	bool BinObjectIndex::Load(const std::string& path, const WADFileSystem& fileSystem)
+	{
+		std::vector<const WAD*> archives;
+		for (const auto& archive : fileSystem.GetArchives())
+			archives.push_back(archive.get());
+		return Load(path, archives);
+	}
+
+	void BinObjectIndex::LoadOrBuild(const std::string& path, const WADFileSystem& fileSystem)
+	{
+		if (Load(path, fileSystem))
+			return;
+
+		Build(fileSystem);
+		Save(path);
+	}
+
+	bool BinObjectIndex::Validate(const std::vector<const WAD*>& archives) const
+	{
+		if (m_size < sizeof(Header))
+			return false;
+
+		const Header& header = GetHeader();
+		if (memcmp(header.magic, IndexMagic, sizeof(IndexMagic)) != 0 || header.version != IndexVersion || header.archiveCount != archives.size())
+			return false;
+
+		// The slot count has to be a power of two with at least one empty slot, or lookups wouldn't end.
+		size_t expectedSize = sizeof(Header) + (size_t)header.archiveCount * sizeof(Archive) + (size_t)header.locationCount * sizeof(Location) + (size_t)header.slotCount * sizeof(u32) + header.namesSize;
+		if (m_size != expectedSize || header.slotCount == 0 || (header.slotCount & (header.slotCount - 1)) != 0 || header.slotCount <= header.locationCount)
+			return false;
+
+		const char* names = reinterpret_cast<const char*>(GetSlots() + header.slotCount);
+		for (u32 i = 0; i < header.archiveCount; i++)
+		{
+			const Archive& archive = GetArchives()[i];
+			if ((size_t)archive.nameOffset + archive.nameLength > header.namesSize || archive.checksum != archives[i]->GetChecksum())
+				return false;
+
+			if (std::string_view(names + archive.nameOffset, archive.nameLength) != archives[i]->GetFileName())
+				return false;
+		}
+
+		for (u32 i = 0; i < header.slotCount; i++)
+			if (GetSlots()[i] > header.locationCount)
+				return false;
+
+		return true;
+	}
+
+	size_t BinObjectIndex::size() const
+	{
+		return IsValid() ? GetHeader().locationCount : 0;
+	}
+
+	const BinObjectIndex::Location* BinObjectIndex::Find(u32 rootHash) const
+	{
+		if (IsValid() == false)
+			return nullptr;
+
+		const u32* slots = GetSlots();
+		u32 mask = GetHeader().slotCount - 1;
+		for (u32 slot = rootHash & mask; slots[slot] != 0; slot = (slot + 1) & mask)
+		{
+			const Location& location = GetLocations()[slots[slot] - 1];
+			if (location.rootHash == rootHash)
+				return &location;
+		}
+
+		return nullptr;
+	}
+
+	std::vector<const BinObjectIndex::Location*> BinObjectIndex::FindAll(u32 rootHash) const
+	{
+		// Locations are sorted by root hash, so the others follow the first one.
+		std::vector<const Location*> result;
+		const Location* location = Find(rootHash);
+		if (location == nullptr)
+			return result;
+
+		const Location* end = GetLocations() + GetHeader().locationCount;
+		for (; location != end && location->rootHash == rootHash; location++)
+			result.push_back(location);
+		return result;
+	}
+
+	const WAD* BinObjectIndex::GetArchive(const Location& location) const
+	{
+		return location.archiveIndex < m_archives.size() ? m_archives[location.archiveIndex] : nullptr;
+	}
+
+	bool BinObjectIndex::ExtractBin(const Location& location, std::vector<u8>& data) const
+	{
+		const WAD* archive = GetArchive(location);
+		return archive && archive->ExtractFile(location.pathHash, data);
+	}
+}
@@ -2,4 +2,380 @@
 
 #include <cassert>
 
-using namespace Spek;
\ No newline at end of file
+using namespace Spek;
+
+namespace LeagueLib
+{
+	using Result = BinParser::Result;
+
+	template<typename T>
+	static bool Read(const u8* data, size_t size, size_t& offset, T& value)
+	{
+		if (offset + sizeof(T) > size)
+			return false;
+
+		memcpy(&value, data + offset, sizeof(T));
+		offset += sizeof(T);
+		return true;
+	}
+
+	static bool Advance(size_t size, size_t& offset, size_t byteCount)
+	{
+		if (offset + byteCount > size)
+			return false;
+
+		offset += byteCount;
+		return true;
+	}
+
+	static Result ToResult(BinVisitor::Action action)
+	{
+		return action == BinVisitor::Stop ? Result::Stopped : Result::Finished;
+	}
+
+	// Fields are read up to size, which is the end of the struct or entry that contains them.
+	static Result ParseFields(const u8* data, size_t size, size_t& offset, u16 count, BinVisitor& visitor)
+	{
+		for (u16 i = 0; i < count; i++)
+		{
+			u32 hash;
+			BinType type;
+			if (Read(data, size, offset, hash) == false || Read(data, size, offset, type) == false)
+				return Result::Malformed;
+
+			BinVisitor::Action action = visitor.OnField(hash, type);
+			if (action == BinVisitor::Stop)
+				return Result::Stopped;
+
+			if (action == BinVisitor::Skip)
+			{
+				if (BinParser::SkipValue(data, size, offset, type) == false)
+					return Result::Malformed;
+				continue;
+			}
+
+			Result result = BinParser::ParseValue(data, size, offset, type, visitor);
+			if (result != Result::Finished)
+				return result;
+		}
+
+		return Result::Finished;
+	}
+
+	static Result ParseElements(const u8* data, size_t size, size_t& offset, BinType type, u32 count, BinVisitor& visitor)
+	{
+		for (u32 i = 0; i < count; i++)
+		{
+			Result result = BinParser::ParseValue(data, size, offset, type, visitor);
+			if (result != Result::Finished)
+				return result;
+		}
+
+		return Result::Finished;
+	}
+
+	void BinParser::Load(const std::string& filePath, OnLoadFunction onLoadFunction)
+	{
+		m_file = File::Load(filePath.c_str(), [this, onLoadFunction](File::Handle file, File::LoadState inLoadState)
+		{
+			m_file = file;
+			m_loadState = inLoadState;
+			if (onLoadFunction)
+				onLoadFunction(*this);
+		});
+	}
+
+	Result BinParser::Parse(BinVisitor& visitor) const
+	{
+		if (m_file == nullptr || m_loadState != File::LoadState::Loaded)
+			return Result::Malformed;
+
+		const std::vector<u8>& data = m_file->GetData();
+		return Parse(data.data(), data.size(), visitor);
+	}
+
+	Result BinParser::Parse(const u8* data, size_t size, BinVisitor& visitor)
+	{
+		size_t offset = 0;
+		if (size < 4 || memcmp(data, "PROP", 4) != 0)
+			return Result::Malformed;
+		offset += 4;
+
+		u32 version;
+		if (Read(data, size, offset, version) == false || version > 3)
+			return Result::Malformed;
+
+		if (version >= 2)
+		{
+			u32 linkedFilesCount;
+			if (Read(data, size, offset, linkedFilesCount) == false)
+				return Result::Malformed;
+
+			for (u32 i = 0; i < linkedFilesCount; i++)
+			{
+				u16 stringLength;
+				size_t start = offset + sizeof(u16);
+				if (Read(data, size, offset, stringLength) == false || Advance(size, offset, stringLength) == false)
+					return Result::Malformed;
+
+				if (visitor.OnLinkedFile(std::string_view((const char*)data + start, stringLength)) == BinVisitor::Stop)
+					return Result::Stopped;
+			}
+		}
+
+		u32 entryCount;
+		if (Read(data, size, offset, entryCount) == false)
+			return Result::Malformed;
+
+		const u8* typeHashes = data + offset;
+		if (Advance(size, offset, (size_t)entryCount * sizeof(u32)) == false)
+			return Result::Malformed;
+
+		for (u32 i = 0; i < entryCount; i++)
+		{
+			u32 length;
+			if (Read(data, size, offset, length) == false)
+				return Result::Malformed;
+
+			size_t end = offset + length;
+			u32 hash;
+			if (end > size || Read(data, end, offset, hash) == false)
+				return Result::Malformed;
+
+			u32 typeHash;
+			memcpy(&typeHash, typeHashes + i * sizeof(u32), sizeof(u32));
+
+			BinVisitor::Action action = visitor.OnBeginEntry(hash, typeHash);
+			if (action == BinVisitor::Stop)
+				return Result::Stopped;
+
+			if (action == BinVisitor::Enter)
+			{
+				u16 count;
+				if (Read(data, end, offset, count) == false)
+					return Result::Malformed;
+
+				Result result = ParseFields(data, end, offset, count, visitor);
+				if (result != Result::Finished)
+					return result;
+
+				if (visitor.OnEndEntry(hash) == BinVisitor::Stop)
+					return Result::Stopped;
+			}
+
+			offset = end;
+		}
+
+		return Result::Finished;
+	}
+
+	Result BinParser::ParseValue(const u8* data, size_t size, size_t& offset, BinType type, BinVisitor& visitor)
+	{
+		switch (type)
+		{
+		case BinType::String:
+		{
+			size_t start = offset;
+			if (SkipValue(data, size, offset, type) == false)
+				return Result::Malformed;
+
+			return ToResult(visitor.OnValue({ type, data + start, offset - start }));
+		}
+
+		case BinType::Struct:
+		case BinType::Embedded:
+		{
+			u32 typeHash;
+			if (Read(data, size, offset, typeHash) == false)
+				return Result::Malformed;
+
+			if (typeHash == 0)
+			{
+				BinVisitor::Action action = visitor.OnBeginStruct(0);
+				if (action == BinVisitor::Enter)
+					action = visitor.OnEndStruct();
+				return ToResult(action);
+			}
+
+			u32 length;
+			if (Read(data, size, offset, length) == false || offset + length > size)
+				return Result::Malformed;
+
+			size_t end = offset + length;
+			BinVisitor::Action action = visitor.OnBeginStruct(typeHash);
+			if (action != BinVisitor::Enter)
+			{
+				offset = end;
+				return ToResult(action);
+			}
+
+			u16 count;
+			if (Read(data, end, offset, count) == false)
+				return Result::Malformed;
+
+			Result result = ParseFields(data, end, offset, count, visitor);
+			if (result != Result::Finished)
+				return result;
+
+			offset = end;
+			return ToResult(visitor.OnEndStruct());
+		}
+
+		case BinType::Container:
+		case BinType::Container2:
+		{
+			BinType elementType;
+			u32 length;
+			if (Read(data, size, offset, elementType) == false || Read(data, size, offset, length) == false || offset + length > size)
+				return Result::Malformed;
+
+			size_t end = offset + length;
+			u32 count;
+			if (Read(data, end, offset, count) == false)
+				return Result::Malformed;
+
+			BinVisitor::Action action = visitor.OnBeginContainer(type, elementType, count);
+			if (action != BinVisitor::Enter)
+			{
+				offset = end;
+				return ToResult(action);
+			}
+
+			Result result = ParseElements(data, end, offset, elementType, count, visitor);
+			if (result != Result::Finished)
+				return result;
+
+			offset = end;
+			return ToResult(visitor.OnEndContainer());
+		}
+
+		case BinType::Array:
+		{
+			// Arrays don't have a length, so skipping them means skipping every element.
+			BinType elementType;
+			u8 count;
+			if (Read(data, size, offset, elementType) == false || Read(data, size, offset, count) == false)
+				return Result::Malformed;
+
+			BinVisitor::Action action = visitor.OnBeginContainer(type, elementType, count);
+			if (action == BinVisitor::Stop)
+				return Result::Stopped;
+
+			if (action == BinVisitor::Skip)
+			{
+				for (u8 i = 0; i < count; i++)
+					if (SkipValue(data, size, offset, elementType) == false)
+						return Result::Malformed;
+				return Result::Finished;
+			}
+
+			Result result = ParseElements(data, size, offset, elementType, count, visitor);
+			if (result != Result::Finished)
+				return result;
+
+			return ToResult(visitor.OnEndContainer());
+		}
+
+		case BinType::Map:
+		{
+			BinType keyType;
+			BinType valueType;
+			u32 length;
+			if (Read(data, size, offset, keyType) == false || Read(data, size, offset, valueType) == false ||
+				Read(data, size, offset, length) == false || offset + length > size)
+				return Result::Malformed;
+
+			size_t end = offset + length;
+			u32 count;
+			if (Read(data, end, offset, count) == false)
+				return Result::Malformed;
+
+			BinVisitor::Action action = visitor.OnBeginMap(keyType, valueType, count);
+			if (action != BinVisitor::Enter)
+			{
+				offset = end;
+				return ToResult(action);
+			}
+
+			for (u32 i = 0; i < count; i++)
+			{
+				Result result = ParseValue(data, end, offset, keyType, visitor);
+				if (result == Result::Finished)
+					result = ParseValue(data, end, offset, valueType, visitor);
+				if (result != Result::Finished)
+					return result;
+			}
+
+			offset = end;
+			return ToResult(visitor.OnEndMap());
+		}
+
+		default:
+		{
+			size_t valueSize = GetBinTypeSize(type);
+			if (valueSize == 0 || offset + valueSize > size)
+				return Result::Malformed;
+
+			BinValueView value = { type, data + offset, valueSize };
+			offset += valueSize;
+			return ToResult(visitor.OnValue(value));
+		}
+		}
+	}
+
+	bool BinParser::SkipValue(const u8* data, size_t size, size_t& offset, BinType type)
+	{
+		size_t valueSize = GetBinTypeSize(type);
+		if (valueSize != 0)
+			return Advance(size, offset, valueSize);
+
+		switch (type)
+		{
+		case BinType::String:
+		{
+			u16 stringLength;
+			return Read(data, size, offset, stringLength) && Advance(size, offset, stringLength);
+		}
+
+		case BinType::Struct:
+		case BinType::Embedded:
+		{
+			u32 typeHash;
+			if (Read(data, size, offset, typeHash) == false)
+				return false;
+
+			u32 length;
+			return typeHash == 0 || (Read(data, size, offset, length) && Advance(size, offset, length));
+		}
+
+		case BinType::Container:
+		case BinType::Container2:
+		{
+			u32 length;
+			return Advance(size, offset, sizeof(BinType)) && Read(data, size, offset, length) && Advance(size, offset, length);
+		}
+
+		case BinType::Map:
+		{
+			u32 length;
+			return Advance(size, offset, 2 * sizeof(BinType)) && Read(data, size, offset, length) && Advance(size, offset, length);
+		}
+
+		case BinType::Array:
+		{
+			BinType elementType;
+			u8 count;
+			if (Read(data, size, offset, elementType) == false || Read(data, size, offset, count) == false)
+				return false;
+
+			for (u8 i = 0; i < count; i++)
+				if (SkipValue(data, size, offset, elementType) == false)
+					return false;
+			return true;
+		}
+
+		default:
+			return false;
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#include <league_lib/bin/bin_patcher.hpp>
+
+namespace LeagueLib
+{
+	bool BinPatcher::Open(u8* data, size_t size)
+	{
+		m_data = nullptr;
+		m_size = 0;
+		m_header = {};
+		if (Bin::ReadHeader(data, size, m_header) == false)
+			return false;
+
+		m_data = data;
+		m_size = size;
+		return true;
+	}
+
+	size_t BinPatcher::Patch(const BinQuery& query, const PatchFunction& patch)
+	{
+		if (IsOpen() == false)
+			return 0;
+
+		size_t patchCount = 0;
+		query.Evaluate(m_data, m_size, m_header.entries, [this, &patch, &patchCount](u32, const BinValueView& value)
+		{
+			size_t valueSize = GetBinTypeSize(value.type);
+			if (valueSize == 0 || value.size != valueSize)
+				return;
+
+			// The query only reads the data, but it points into our own buffer.
+			u8* data = m_data + (value.data - m_data);
+			if (patch(value.type, data))
+				patchCount++;
+		});
+
+		return patchCount;
+	}
+}
@@ -0,0 +1,619 @@
+#include <league_lib/bin/bin_query.hpp>
+#include <league_lib/util/thread_pool.hpp>
+
+#include <charconv>
+#include <cstring>
+
+using namespace Spek;
+
+namespace LeagueLib
+{
+	using Step = BinQuery::Step;
+
+	template<typename T>
+	static bool Read(const u8* data, size_t size, size_t& offset, T& value)
+	{
+		if (offset + sizeof(T) > size)
+			return false;
+
+		memcpy(&value, data + offset, sizeof(T));
+		offset += sizeof(T);
+		return true;
+	}
+
+	template<typename T>
+	static u64 ReadAs(const u8* data)
+	{
+		T value;
+		memcpy(&value, data, sizeof(T));
+		return std::is_signed_v<T> ? (u64)(i64)value : (u64)value;
+	}
+
+	static bool ParseNumber(std::string_view text, u64& number)
+	{
+		int base = 10;
+		if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X'))
+		{
+			text.remove_prefix(2);
+			base = 16;
+		}
+
+		auto result = std::from_chars(text.data(), text.data() + text.size(), number, base);
+		return text.empty() == false && result.ec == std::errc() && result.ptr == text.data() + text.size();
+	}
+
+	static bool IntegerKeyMatches(const Step& step, u64 value, size_t size)
+	{
+		if (step.isNumber)
+			return value == step.number;
+
+		// Names match hashed keys: FNV for 32 bit keys, and the path hash for 64 bit keys.
+		// Signed keys are sign-extended, so 32 bit keys are compared as 32 bits.
+		if (size == sizeof(u32))
+			return (u32)value == step.hash;
+		if (size == sizeof(u64))
+			return value == step.number;
+		return false;
+	}
+
+	static bool KeyMatches(const Step& step, const BinValueView& key)
+	{
+		switch (key.type)
+		{
+		case BinType::String:	return step.isNumber == false && key.GetString() == step.text;
+		case BinType::Bool:
+		case BinType::Flag:
+		case BinType::U8:		return IntegerKeyMatches(step, ReadAs<u8>(key.data), key.size);
+		case BinType::S8:		return IntegerKeyMatches(step, ReadAs<i8>(key.data), key.size);
+		case BinType::S16:		return IntegerKeyMatches(step, ReadAs<i16>(key.data), key.size);
+		case BinType::U16:		return IntegerKeyMatches(step, ReadAs<u16>(key.data), key.size);
+		case BinType::S32:		return IntegerKeyMatches(step, ReadAs<i32>(key.data), key.size);
+		case BinType::U32:
+		case BinType::Hash:
+		case BinType::Link:		return IntegerKeyMatches(step, ReadAs<u32>(key.data), key.size);
+		case BinType::S64:		return IntegerKeyMatches(step, ReadAs<i64>(key.data), key.size);
+		case BinType::U64:
+		case BinType::Path:		return IntegerKeyMatches(step, ReadAs<u64>(key.data), key.size);
+		default:				return false;
+		}
+	}
+
+	static bool KeyMatches(const Step& step, const BinVariable& key)
+	{
+		return key.Visit([&step](auto&& value) -> bool
+		{
+			using Type = DECAY_TYPE(value);
+			if constexpr (std::is_same_v<Type, BinString>)
+				return step.isNumber == false && value == step.text;
+			else if constexpr (std::is_integral_v<Type>)
+				return IntegerKeyMatches(step, std::is_signed_v<Type> ? (u64)(i64)value : (u64)value, sizeof(Type));
+			else
+				return false;
+		});
+	}
+
+	// Uses the key index of the map, only maps with keys of different types are searched one by one.
+	static BinMap::Storage::const_iterator FindKey(const Step& step, const BinMap& map)
+	{
+		u8 keyType = map.GetKeyTypeIndex();
+		if (keyType == BinTypeIndex<BinString>)
+			return step.isNumber ? map.end() : map.find(std::string_view(step.text));
+
+		if (keyType >= BinTypeIndex<i8> && keyType <= BinTypeIndex<u64>)
+		{
+			if (step.isNumber)
+				return map.find(step.number);
+			// The map keeps signed keys sign-extended.
+			if (keyType == BinTypeIndex<i32>)
+				return map.find((u64)(i64)(i32)step.hash);
+			if (keyType == BinTypeIndex<u32>)
+				return map.find((u64)step.hash);
+			if (keyType == BinTypeIndex<i64> || keyType == BinTypeIndex<u64>)
+				return map.find(step.number);
+			return map.end();
+		}
+
+		if (keyType != 0)
+			return map.end();
+
+		for (auto pair = map.begin(); pair != map.end(); ++pair)
+			if (KeyMatches(step, pair->first))
+				return pair;
+		return map.end();
+	}
+
+	// Walks the file data of a single entry. Everything that isn't on the path is skipped using its length.
+	struct StreamQuery
+	{
+		const std::vector<Step>& steps;
+		const u8* data;
+		u32 entryHash;
+		const BinQuery::OnValueFunction& onValue;
+
+		// Returns false if the data is malformed.
+		bool MatchFields(size_t size, size_t& offset, u16 count, size_t stepIndex) const
+		{
+			const Step& step = steps[stepIndex];
+			if (step.kind != Step::Kind::Field && step.kind != Step::Kind::AnyField)
+				return true;
+
+			for (u16 i = 0; i < count; i++)
+			{
+				u32 hash;
+				BinType type;
+				if (Read(data, size, offset, hash) == false || Read(data, size, offset, type) == false)
+					return false;
+
+				if (step.kind == Step::Kind::AnyField)
+				{
+					if (MatchValue(size, offset, type, stepIndex + 1) == false)
+						return false;
+				}
+				else if (step.hash == hash)
+				{
+					// Field hashes are unique within a struct, the caller skips the rest.
+					return MatchValue(size, offset, type, stepIndex + 1);
+				}
+				else if (BinParser::SkipValue(data, size, offset, type) == false)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		bool MatchElements(size_t size, size_t& offset, BinType elementType, u32 count, size_t stepIndex) const
+		{
+			const Step& step = steps[stepIndex];
+			if (step.kind == Step::Kind::Index)
+			{
+				if (step.index >= count)
+					return true;
+
+				// Fixed size elements can be jumped over all at once.
+				size_t elementSize = GetBinTypeSize(elementType);
+				if (elementSize != 0)
+				{
+					offset += step.index * elementSize;
+				}
+				else
+				{
+					for (u32 i = 0; i < step.index; i++)
+						if (BinParser::SkipValue(data, size, offset, elementType) == false)
+							return false;
+				}
+
+				return MatchValue(size, offset, elementType, stepIndex + 1);
+			}
+
+			if (step.kind != Step::Kind::AnyElement)
+				return true;
+
+			for (u32 i = 0; i < count; i++)
+				if (MatchValue(size, offset, elementType, stepIndex + 1) == false)
+					return false;
+			return true;
+		}
+
+		bool MatchValue(size_t size, size_t& offset, BinType type, size_t stepIndex) const
+		{
+			if (stepIndex == steps.size())
+			{
+				size_t start = offset;
+				if (BinParser::SkipValue(data, size, offset, type) == false)
+					return false;
+
+				onValue(entryHash, { type, data + start, offset - start });
+				return true;
+			}
+
+			switch (type)
+			{
+			case BinType::Struct:
+			case BinType::Embedded:
+			{
+				u32 typeHash;
+				if (Read(data, size, offset, typeHash) == false)
+					return false;
+				if (typeHash == 0)
+					return true;
+
+				u32 length;
+				if (Read(data, size, offset, length) == false || offset + length > size)
+					return false;
+
+				size_t end = offset + length;
+				u16 count;
+				if (Read(data, end, offset, count) == false || MatchFields(end, offset, count, stepIndex) == false)
+					return false;
+
+				offset = end;
+				return true;
+			}
+
+			case BinType::Container:
+			case BinType::Container2:
+			{
+				BinType elementType;
+				u32 length;
+				if (Read(data, size, offset, elementType) == false || Read(data, size, offset, length) == false || offset + length > size)
+					return false;
+
+				size_t end = offset + length;
+				u32 count;
+				if (Read(data, end, offset, count) == false || MatchElements(end, offset, elementType, count, stepIndex) == false)
+					return false;
+
+				offset = end;
+				return true;
+			}
+
+			case BinType::Array:
+			{
+				// Arrays have no length, so the elements after the match have to be skipped one by one.
+				BinType elementType;
+				u8 count;
+				if (Read(data, size, offset, elementType) == false || Read(data, size, offset, count) == false)
+					return false;
+
+				const Step& step = steps[stepIndex];
+				for (u32 i = 0; i < count; i++)
+				{
+					bool isMatch = step.kind == Step::Kind::AnyElement || (step.kind == Step::Kind::Index && step.index == i);
+					bool isValid = isMatch ? MatchValue(size, offset, elementType, stepIndex + 1) : BinParser::SkipValue(data, size, offset, elementType);
+					if (isValid == false)
+						return false;
+				}
+				return true;
+			}
+
+			case BinType::Map:
+			{
+				BinType keyType;
+				BinType valueType;
+				u32 length;
+				if (Read(data, size, offset, keyType) == false || Read(data, size, offset, valueType) == false ||
+					Read(data, size, offset, length) == false || offset + length > size)
+					return false;
+
+				size_t end = offset + length;
+				u32 count;
+				if (Read(data, end, offset, count) == false)
+					return false;
+
+				const Step& step = steps[stepIndex];
+				if (step.kind == Step::Kind::Key || step.kind == Step::Kind::AnyElement)
+				{
+					for (u32 i = 0; i < count; i++)
+					{
+						size_t keyStart = offset;
+						if (BinParser::SkipValue(data, end, offset, keyType) == false)
+							return false;
+
+						bool isMatch = step.kind == Step::Kind::AnyElement || KeyMatches(step, { keyType, data + keyStart, offset - keyStart });
+						bool isValid = isMatch ? MatchValue(end, offset, valueType, stepIndex + 1) : BinParser::SkipValue(data, end, offset, valueType);
+						if (isValid == false)
+							return false;
+					}
+				}
+
+				offset = end;
+				return true;
+			}
+
+			default:
+				return BinParser::SkipValue(data, size, offset, type);
+			}
+		}
+	};
+
+	template<typename Function>
+	static void MatchVariable(const std::vector<Step>& steps, size_t stepIndex, const BinVariable& value, const Function& onVariable)
+	{
+		if (stepIndex == steps.size())
+		{
+			onVariable(value);
+			return;
+		}
+
+		const Step& step = steps[stepIndex];
+		switch (step.kind)
+		{
+		case Step::Kind::Field:
+			if (const BinObject* object = value.As<BinObject>())
+			{
+				auto field = object->find(step.hash);
+				if (field != object->end())
+					MatchVariable(steps, stepIndex + 1, field->second, onVariable);
+			}
+			break;
+
+		case Step::Kind::AnyField:
+			if (const BinObject* object = value.As<BinObject>())
+				for (const auto& field : *object)
+					MatchVariable(steps, stepIndex + 1, field.second, onVariable);
+			break;
+
+		case Step::Kind::Index:
+			if (const BinArray* array = value.As<BinArray>())
+				if (step.index < array->size())
+					MatchVariable(steps, stepIndex + 1, (*array)[step.index], onVariable);
+			break;
+
+		case Step::Kind::AnyElement:
+			if (const BinArray* array = value.As<BinArray>())
+			{
+				for (const BinVariable& element : *array)
+					MatchVariable(steps, stepIndex + 1, element, onVariable);
+			}
+			else if (const BinMap* map = value.As<BinMap>())
+			{
+				for (const auto& pair : *map)
+					MatchVariable(steps, stepIndex + 1, pair.second, onVariable);
+			}
+			break;
+
+		case Step::Kind::Key:
+			if (const BinMap* map = value.As<BinMap>())
+			{
+				auto pair = FindKey(step, *map);
+				if (pair != map->end())
+					MatchVariable(steps, stepIndex + 1, pair->second, onVariable);
+			}
+			break;
+		}
+	}
+
+	BinQuery BinQuery::Compile(std::string_view path)
+	{
+		BinQuery query;
+		auto invalid = [&query]()
+		{
+			query.m_isValid = false;
+			return query;
+		};
+
+		size_t end = path.find_first_of(".[{");
+		std::string_view entry = path.substr(0, end);
+		u64 hash;
+		if (entry == "*")
+			query.AnyEntry();
+		else if (entry.empty())
+			return invalid();
+		else if (entry.size() > 2 && entry[0] == '0' && ParseNumber(entry, hash))
+			query.Entry((u32)hash);
+		else
+			query.Entry(entry);
+
+		size_t position = end;
+		while (position < path.size())
+		{
+			char type = path[position++];
+			if (type == '.')
+			{
+				end = path.find_first_of(".[{", position);
+				std::string_view name = path.substr(position, end - position);
+				position = end;
+
+				if (name == "*")
+					query.AnyField();
+				else if (name.empty())
+					return invalid();
+				else if (name.size() > 2 && name[0] == '0' && ParseNumber(name, hash))
+					query.Field(BinFieldKey((u32)hash));
+				else
+					query.Field(name);
+				continue;
+			}
+
+			// Quoted keys are read up to the closing quote, as they can contain a }.
+			if (type == '{' && position < path.size() && path[position] == '"')
+			{
+				std::string key;
+				for (position++; position < path.size() && path[position] != '"'; position++)
+				{
+					if (path[position] == '\\' && position + 1 < path.size())
+						position++;
+					key += path[position];
+				}
+
+				if (position + 1 >= path.size() || path[position + 1] != '}')
+					return invalid();
+
+				position += 2;
+				query.Key(key);
+				continue;
+			}
+
+			char close = type == '[' ? ']' : '}';
+			end = path.find(close, position);
+			if (end == std::string_view::npos)
+				return invalid();
+
+			std::string_view argument = path.substr(position, end - position);
+			position = end + 1;
+
+			u64 number;
+			if (type == '[')
+			{
+				if (argument == "*")
+					query.AnyElement();
+				else if (ParseNumber(argument, number))
+					query.Index((u32)number);
+				else
+					return invalid();
+			}
+			else
+			{
+				if (ParseNumber(argument, number))
+					query.Key(number);
+				else
+					return invalid();
+			}
+		}
+
+		return query;
+	}
+
+	BinQuery& BinQuery::Entry(std::string_view name)
+	{
+		return Entry(HashName(name));
+	}
+
+	BinQuery& BinQuery::Entry(u32 hash)
+	{
+		m_entryHash = hash;
+		m_matchesAnyEntry = false;
+		return *this;
+	}
+
+	BinQuery& BinQuery::AnyEntry()
+	{
+		m_entryHash = 0;
+		m_matchesAnyEntry = true;
+		return *this;
+	}
+
+	BinQuery& BinQuery::Field(std::string_view name)
+	{
+		return Field(BinFieldKey(HashName(name)));
+	}
+
+	BinQuery& BinQuery::Field(BinFieldKey key)
+	{
+		Step& step = m_steps.emplace_back();
+		step.kind = Step::Kind::Field;
+		step.hash = key.hash;
+		return *this;
+	}
+
+	BinQuery& BinQuery::AnyField()
+	{
+		m_steps.emplace_back().kind = Step::Kind::AnyField;
+		return *this;
+	}
+
+	BinQuery& BinQuery::Index(u32 index)
+	{
+		Step& step = m_steps.emplace_back();
+		step.kind = Step::Kind::Index;
+		step.index = index;
+		return *this;
+	}
+
+	BinQuery& BinQuery::AnyElement()
+	{
+		m_steps.emplace_back().kind = Step::Kind::AnyElement;
+		return *this;
+	}
+
+	BinQuery& BinQuery::Key(std::string_view key)
+	{
+		Step& step = m_steps.emplace_back();
+		step.kind = Step::Kind::Key;
+		step.text = std::string(key);
+		step.hash = HashName(key);
+		step.number = HashPath(key);
+		return *this;
+	}
+
+	BinQuery& BinQuery::Key(u64 key)
+	{
+		Step& step = m_steps.emplace_back();
+		step.kind = Step::Kind::Key;
+		step.number = key;
+		step.isNumber = true;
+		return *this;
+	}
+
+	void BinQuery::Evaluate(const Bin& bin, const OnValueFunction& onValue) const
+	{
+		if (m_isValid == false || bin.GetLoadState() != File::LoadState::Loaded)
+			return;
+
+		const std::vector<u8>& data = bin.GetFile()->GetData();
+		if (m_matchesAnyEntry == false)
+		{
+			if (const Bin::Entry* entry = bin.FindEntry(m_entryHash))
+				EvaluateEntry(data.data(), data.size(), *entry, onValue);
+			return;
+		}
+
+		for (const Bin::Entry& entry : bin.GetEntries())
+			EvaluateEntry(data.data(), data.size(), entry, onValue);
+	}
+
+	void BinQuery::Evaluate(const u8* data, size_t size, const std::vector<Bin::Entry>& entries, const OnValueFunction& onValue) const
+	{
+		if (m_isValid == false)
+			return;
+
+		for (const Bin::Entry& entry : entries)
+			if (m_matchesAnyEntry || entry.hash == m_entryHash)
+				EvaluateEntry(data, size, entry, onValue);
+	}
+
+	void BinQuery::EvaluateEntry(const u8* data, size_t size, const Bin::Entry& entry, const OnValueFunction& onValue) const
+	{
+		size_t end = entry.offset + entry.length;
+		size_t offset = entry.offset + sizeof(u32); // Skip the hash
+		if (end > size)
+			return;
+
+		if (m_steps.empty())
+		{
+			onValue(entry.hash, { BinType::Empty, data + offset, end - offset });
+			return;
+		}
+
+		u16 count;
+		if (Read(data, end, offset, count) == false)
+			return;
+
+		StreamQuery query = { m_steps, data, entry.hash, onValue };
+		query.MatchFields(end, offset, count, 0);
+	}
+
+	void BinQuery::EvaluateTree(const Bin& bin, const OnVariableFunction& onVariable) const
+	{
+		if (m_isValid == false || bin.GetLoadState() != File::LoadState::Loaded)
+			return;
+
+		auto evaluateEntry = [this, &bin, &onVariable](u32 hash)
+		{
+			MatchVariable(m_steps, 0, bin[hash], [hash, &onVariable](const BinVariable& value) { onVariable(hash, value); });
+		};
+
+		if (m_matchesAnyEntry == false)
+		{
+			if (bin.FindEntry(m_entryHash))
+				evaluateEntry(m_entryHash);
+			return;
+		}
+
+		for (const Bin::Entry& entry : bin.GetEntries())
+			evaluateEntry(entry.hash);
+	}
+
+	void BinQuery::EvaluateTree(const BinVariable& root, const std::function<void(const BinVariable& value)>& onVariable) const
+	{
+		if (m_isValid)
+			MatchVariable(m_steps, 0, root, onVariable);
+	}
+
+	std::vector<std::vector<BinQuery::Match>> BinQuery::EvaluateBatch(const std::vector<const Bin*>& bins) const
+	{
+		std::vector<std::vector<Match>> results(bins.size());
+		ThreadPool::GetDefault().ParallelFor(bins.size(), 1, [this, &bins, &results](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				std::vector<Match>& matches = results[i];
+				Evaluate(*bins[i], [&matches](u32 entryHash, const BinValueView& value) { matches.push_back({ entryHash, value }); });
+			}
+		});
+
+		return results;
+	}
+}
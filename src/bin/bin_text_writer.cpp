@@ -0,0 +1,689 @@
+#include <league_lib/bin/bin_text_writer.hpp>
+#include <league_lib/bin/bin_parser.hpp>
+#include <league_lib/util/hash.hpp>
+#include <league_lib/wad/wad_hash_dictionary.hpp>
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace LeagueLib
+{
+	// Output to a stream is written out whenever this much has been buffered.
+	static constexpr size_t StreamBlockSize = 64 * 1024;
+
+	void BinNameTable::Add(std::string_view name)
+	{
+		Add(HashName(name), name);
+	}
+
+	void BinNameTable::Add(u32 hash, std::string_view name)
+	{
+		m_names.emplace(hash, name);
+	}
+
+	bool BinNameTable::AddTextList(const char* fileName)
+	{
+		std::ifstream fileStream(fileName, std::ios::binary);
+		if (!fileStream)
+			return false;
+
+		std::string contents((std::istreambuf_iterator<char>(fileStream)), std::istreambuf_iterator<char>());
+		std::string_view text = contents;
+		while (text.empty() == false)
+		{
+			size_t lineEnd = text.find('\n');
+			std::string_view line = text.substr(0, lineEnd);
+			text = lineEnd == std::string_view::npos ? std::string_view() : text.substr(lineEnd + 1);
+
+			if (line.empty() == false && line.back() == '\r')
+				line.remove_suffix(1);
+
+			size_t separator = line.find(' ');
+			if (separator == std::string_view::npos || separator == 0)
+				continue;
+
+			u32 hash = 0;
+			auto [end, error] = std::from_chars(line.data(), line.data() + separator, hash, 16);
+			if (error == std::errc() && end == line.data() + separator)
+				Add(hash, line.substr(separator + 1));
+		}
+
+		return true;
+	}
+
+	bool BinNameTable::Find(u32 hash, std::string_view& name) const
+	{
+		auto index = m_names.find(hash);
+		if (index == m_names.end())
+			return false;
+
+		name = index->second;
+		return true;
+	}
+
+	// The type names of ritobin.
+	static const char* GetTextTypeName(BinType type)
+	{
+		switch (type)
+		{
+		case BinType::Bool:			return "bool";
+		case BinType::S8:			return "i8";
+		case BinType::U8:			return "u8";
+		case BinType::S16:			return "i16";
+		case BinType::U16:			return "u16";
+		case BinType::S32:			return "i32";
+		case BinType::U32:			return "u32";
+		case BinType::S64:			return "i64";
+		case BinType::U64:			return "u64";
+		case BinType::Float:		return "f32";
+		case BinType::Vec2f:		return "vec2";
+		case BinType::Vec3f:		return "vec3";
+		case BinType::Vec4f:		return "vec4";
+		case BinType::Mat4:			return "mtx44";
+		case BinType::RGBA:			return "rgba";
+		case BinType::String:		return "string";
+		case BinType::Hash:			return "hash";
+		case BinType::Path:			return "file";
+		case BinType::Container:	return "list";
+		case BinType::Container2:	return "list2";
+		case BinType::Struct:		return "pointer";
+		case BinType::Embedded:		return "embed";
+		case BinType::Link:			return "link";
+		case BinType::Array:		return "option";
+		case BinType::Map:			return "map";
+		case BinType::Flag:			return "flag";
+		default:					return "none";
+		}
+	}
+
+	class BinTextWriter::Visitor : public BinVisitor
+	{
+	public:
+		Visitor(const BinTextWriter& writer, std::string& output, std::ostream* stream) :
+			m_writer(writer),
+			m_isJson(writer.m_format == Format::Json),
+			m_output(output),
+			m_stream(stream)
+		{
+		}
+
+		void Begin(u32 version)
+		{
+			if (m_isJson)
+			{
+				Append("{\"version\":");
+				AppendNumber(version);
+				Append(",\"linked\":[");
+			}
+			else
+			{
+				Append("#PROP_text\ntype: string = \"PROP\"\nversion: u32 = ");
+				AppendNumber(version);
+				Append("\nlinked: list[string] = {");
+			}
+		}
+
+		void End()
+		{
+			if (m_isInEntries == false)
+				BeginEntries();
+
+			Append(m_isJson ? "}}\n" : "}\n");
+			Flush(true);
+		}
+
+		void Flush(bool isFinal)
+		{
+			if (m_stream && (isFinal || m_output.size() >= StreamBlockSize))
+			{
+				m_stream->write(m_output.data(), m_output.size());
+				m_output.clear();
+			}
+		}
+
+		Action OnLinkedFile(std::string_view name) override
+		{
+			BeginSectionItem();
+			AppendString(name);
+			if (m_isJson == false)
+				Append('\n');
+			return Enter;
+		}
+
+		Action OnBeginEntry(u32 hash, u32 typeHash) override
+		{
+			if (m_isInEntries == false)
+				BeginEntries();
+
+			BeginSectionItem();
+			AppendName(hash, true);
+			if (m_isJson)
+			{
+				Append(":{\"__class\":");
+				AppendName(typeHash, true);
+				m_frames.push_back({ Frame::Kind::Fields, false });
+			}
+			else
+			{
+				Append(" = ");
+				AppendName(typeHash, false);
+				Append(" {");
+				m_frames.push_back({ Frame::Kind::Fields });
+			}
+			return Enter;
+		}
+
+		Action OnEndEntry(u32) override
+		{
+			CloseFrame('}');
+			if (m_isJson == false)
+				Append('\n');
+
+			Flush(false);
+			return Enter;
+		}
+
+		Action OnField(u32 hash, BinType type) override
+		{
+			m_fieldHash = hash;
+			m_fieldType = type;
+			return Enter;
+		}
+
+		Action OnValue(const BinValueView& value) override
+		{
+			BeginValue();
+
+			// JSON only allows strings as keys, so anything that isn't written as one is put in quotes.
+			bool isQuoted = m_isJson && m_frames.back().kind == Frame::Kind::Map && m_frames.back().isKey &&
+				value.type != BinType::String && value.type != BinType::Hash && value.type != BinType::Link && value.type != BinType::Path;
+			if (isQuoted)
+				Append('"');
+
+			AppendValue(value);
+
+			if (isQuoted)
+				Append('"');
+
+			EndValue();
+			return Enter;
+		}
+
+		Action OnBeginStruct(u32 typeHash) override
+		{
+			BeginValue();
+			if (typeHash == 0)
+			{
+				Append("null");
+				m_frames.push_back({ Frame::Kind::Null });
+			}
+			else if (m_isJson)
+			{
+				Append("{\"__class\":");
+				AppendName(typeHash, true);
+				m_frames.push_back({ Frame::Kind::Fields, false });
+			}
+			else
+			{
+				AppendName(typeHash, false);
+				Append(" {");
+				m_frames.push_back({ Frame::Kind::Fields });
+			}
+			return Enter;
+		}
+
+		Action OnEndStruct() override
+		{
+			if (m_frames.back().kind == Frame::Kind::Null)
+				m_frames.pop_back();
+			else
+				CloseFrame('}');
+
+			EndValue();
+			return Enter;
+		}
+
+		Action OnBeginContainer(BinType, BinType elementType, u32) override
+		{
+			BeginValue(elementType);
+			Append(m_isJson ? '[' : '{');
+			m_frames.push_back({ Frame::Kind::Elements });
+			return Enter;
+		}
+
+		Action OnEndContainer() override
+		{
+			CloseFrame(m_isJson ? ']' : '}');
+			EndValue();
+			return Enter;
+		}
+
+		Action OnBeginMap(BinType keyType, BinType valueType, u32) override
+		{
+			BeginValue(keyType, valueType);
+
+			bool hasPairs = m_isJson && (keyType == BinType::Struct || keyType == BinType::Embedded || keyType == BinType::Container ||
+				keyType == BinType::Container2 || keyType == BinType::Array || keyType == BinType::Map);
+			Append(m_isJson && hasPairs ? '[' : '{');
+			m_frames.push_back({ hasPairs ? Frame::Kind::Pairs : Frame::Kind::Map });
+			return Enter;
+		}
+
+		Action OnEndMap() override
+		{
+			CloseFrame(m_isJson && m_frames.back().kind == Frame::Kind::Pairs ? ']' : '}');
+			EndValue();
+			return Enter;
+		}
+
+	private:
+		struct Frame
+		{
+			enum class Kind : u8
+			{
+				Fields,
+				Elements,
+				Map,
+				Pairs, // JSON maps with keys that can't be written as strings
+				Null
+			};
+
+			Kind kind;
+			bool isFirst = true;
+			bool isKey = true;
+		};
+
+		// The linked files and entries are written as a list and a map at the top level of the file.
+		void BeginEntries()
+		{
+			if (m_isJson)
+				Append("],\"entries\":{");
+			else
+				Append("}\nentries: map[hash,embed] = {");
+
+			m_isInEntries = true;
+			m_isFirst = true;
+		}
+
+		void BeginSectionItem()
+		{
+			if (m_isJson)
+			{
+				if (m_isFirst == false)
+					Append(',');
+			}
+			else
+			{
+				if (m_isFirst)
+					Append('\n');
+				AppendIndent(1);
+			}
+			m_isFirst = false;
+		}
+
+		// Writes whatever comes before a value, depending on where it is.
+		void BeginValue(BinType elementType = BinType::Empty, BinType valueType = BinType::Empty)
+		{
+			Frame& frame = m_frames.back();
+			bool isFirst = frame.isFirst;
+			frame.isFirst = false;
+
+			if (m_isJson)
+			{
+				if (isFirst == false && ((frame.kind != Frame::Kind::Map && frame.kind != Frame::Kind::Pairs) || frame.isKey))
+					Append(',');
+
+				if (frame.kind == Frame::Kind::Fields)
+				{
+					AppendName(m_fieldHash, true);
+					Append(':');
+				}
+				else if (frame.kind == Frame::Kind::Pairs && frame.isKey)
+				{
+					Append('[');
+				}
+				return;
+			}
+
+			if (frame.kind == Frame::Kind::Map && frame.isKey == false)
+				return;
+
+			if (isFirst)
+				Append('\n');
+			AppendIndent(m_frames.size() + 1);
+
+			if (frame.kind == Frame::Kind::Fields)
+			{
+				AppendName(m_fieldHash, false);
+				Append(": ");
+				Append(GetTextTypeName(m_fieldType));
+				if (m_fieldType == BinType::Container || m_fieldType == BinType::Container2 || m_fieldType == BinType::Array)
+				{
+					Append('[');
+					Append(GetTextTypeName(elementType));
+					Append(']');
+				}
+				else if (m_fieldType == BinType::Map)
+				{
+					Append('[');
+					Append(GetTextTypeName(elementType));
+					Append(',');
+					Append(GetTextTypeName(valueType));
+					Append(']');
+				}
+				Append(" = ");
+			}
+		}
+
+		// Writes whatever comes after a value, depending on where it is.
+		void EndValue()
+		{
+			Frame& frame = m_frames.back();
+			switch (frame.kind)
+			{
+			case Frame::Kind::Map:
+				if (frame.isKey)
+					Append(m_isJson ? ":" : " = ");
+				else if (m_isJson == false)
+					Append('\n');
+				frame.isKey = !frame.isKey;
+				break;
+
+			case Frame::Kind::Pairs:
+				Append(frame.isKey ? ',' : ']');
+				frame.isKey = !frame.isKey;
+				break;
+
+			default:
+				if (m_isJson == false)
+					Append('\n');
+				break;
+			}
+		}
+
+		void CloseFrame(char close)
+		{
+			bool isEmpty = m_frames.back().isFirst;
+			m_frames.pop_back();
+
+			if (m_isJson == false && isEmpty == false)
+				AppendIndent(m_frames.size() + 1);
+			Append(close);
+		}
+
+		void AppendValue(const BinValueView& value)
+		{
+			switch (value.type)
+			{
+			case BinType::Bool:
+			case BinType::Flag:
+				Append(value.Get<u8>() ? "true" : "false");
+				break;
+
+			case BinType::S8:		AppendNumber(value.Get<i8>()); break;
+			case BinType::U8:		AppendNumber(value.Get<u8>()); break;
+			case BinType::S16:		AppendNumber(value.Get<i16>()); break;
+			case BinType::U16:		AppendNumber(value.Get<u16>()); break;
+			case BinType::S32:		AppendNumber(value.Get<i32>()); break;
+			case BinType::U32:		AppendNumber(value.Get<u32>()); break;
+			case BinType::S64:		AppendNumber(value.Get<i64>()); break;
+			case BinType::U64:		AppendNumber(value.Get<u64>()); break;
+			case BinType::Float:	AppendFloat(value.Get<float>()); break;
+
+			case BinType::Vec2f:
+			case BinType::Vec3f:
+			case BinType::Vec4f:
+			case BinType::Mat4:
+			{
+				size_t count = value.size / sizeof(float);
+				Append(m_isJson ? "[" : "{ ");
+				for (size_t i = 0; i < count; i++)
+				{
+					if (i > 0)
+						Append(m_isJson ? "," : ", ");
+
+					float element;
+					memcpy(&element, value.data + i * sizeof(float), sizeof(float));
+					AppendFloat(element);
+				}
+				Append(m_isJson ? "]" : " }");
+				break;
+			}
+
+			case BinType::RGBA:
+				Append(m_isJson ? "[" : "{ ");
+				for (size_t i = 0; i < 4; i++)
+				{
+					if (i > 0)
+						Append(m_isJson ? "," : ", ");
+					AppendNumber(value.data[i]);
+				}
+				Append(m_isJson ? "]" : " }");
+				break;
+
+			case BinType::String:
+				AppendString(value.GetString());
+				break;
+
+			case BinType::Hash:
+			case BinType::Link:
+				AppendName(value.Get<u32>(), true);
+				break;
+
+			case BinType::Path:
+				AppendPath(value.Get<u64>());
+				break;
+
+			default:
+				Append("null");
+				break;
+			}
+		}
+
+		// Names are quoted when they are values, or when writing JSON. Hashes without a name are written as hex.
+		void AppendName(u32 hash, bool isQuoted)
+		{
+			std::string_view name;
+			if (m_writer.m_names && m_writer.m_names->Find(hash, name))
+			{
+				if (isQuoted || m_isJson)
+					AppendString(name);
+				else
+					Append(name);
+				return;
+			}
+
+			char buffer[16];
+			snprintf(buffer, sizeof(buffer), "0x%08x", hash);
+			AppendHex(buffer);
+		}
+
+		void AppendPath(u64 hash)
+		{
+			if (m_writer.m_paths && m_writer.m_paths->Find(hash, m_path))
+			{
+				AppendString(m_path);
+				return;
+			}
+
+			char buffer[32];
+			snprintf(buffer, sizeof(buffer), "0x%016llx", (unsigned long long)hash);
+			AppendHex(buffer);
+		}
+
+		// Unknown hashes are strings in JSON, and bare in ritobin.
+		void AppendHex(const char* hex)
+		{
+			if (m_isJson)
+			{
+				Append('"');
+				Append(hex);
+				Append('"');
+			}
+			else
+			{
+				Append(hex);
+			}
+		}
+
+		void AppendString(std::string_view string)
+		{
+			Append('"');
+
+			size_t runStart = 0;
+			for (size_t i = 0; i < string.size(); i++)
+			{
+				u8 c = (u8)string[i];
+				if (c >= 0x20 && c != '"' && c != '\\')
+					continue;
+
+				m_output.append(string.data() + runStart, i - runStart);
+				runStart = i + 1;
+
+				switch (c)
+				{
+				case '"':	Append("\\\""); break;
+				case '\\':	Append("\\\\"); break;
+				case '\n':	Append("\\n"); break;
+				case '\r':	Append("\\r"); break;
+				case '\t':	Append("\\t"); break;
+				default:
+				{
+					char buffer[8];
+					snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+					Append(buffer);
+					break;
+				}
+				}
+			}
+			m_output.append(string.data() + runStart, string.size() - runStart);
+
+			Append('"');
+		}
+
+		template<typename T>
+		void AppendNumber(T value)
+		{
+			char buffer[32];
+			auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+			m_output.append(buffer, result.ptr - buffer);
+		}
+
+		// The shortest text that reads back as the same float.
+		void AppendFloat(float value)
+		{
+			if (m_isJson && std::isfinite(value) == false)
+			{
+				Append("null");
+				return;
+			}
+
+			AppendNumber(value);
+		}
+
+		void AppendIndent(size_t depth) { m_output.append(depth * 4, ' '); }
+		void Append(std::string_view text) { m_output.append(text); }
+		void Append(char c) { m_output.push_back(c); }
+
+		const BinTextWriter& m_writer;
+		bool m_isJson;
+		std::string& m_output;
+		std::ostream* m_stream;
+
+		std::vector<Frame> m_frames;
+		u32 m_fieldHash = 0;
+		BinType m_fieldType = BinType::Empty;
+
+		// For the top level lists
+		bool m_isInEntries = false;
+		bool m_isFirst = true;
+
+		std::string m_path;
+	};
+
+	BinTextWriter& BinTextWriter::SetNames(const BinNameTable* names)
+	{
+		m_names = names;
+		return *this;
+	}
+
+	BinTextWriter& BinTextWriter::SetPaths(const WADHashDictionary* paths)
+	{
+		m_paths = paths;
+		return *this;
+	}
+
+	BinTextWriter& BinTextWriter::SetFileFilter(FileFilterFunction filter)
+	{
+		m_fileFilter = std::move(filter);
+		return *this;
+	}
+
+	bool BinTextWriter::Write(const u8* data, size_t size, std::string& output) const
+	{
+		// The text is usually a few times larger than the file, so this saves most of the regrowing.
+		output.reserve(output.size() + size * 2);
+		return Write(data, size, output, nullptr);
+	}
+
+	bool BinTextWriter::Write(const Bin& bin, std::string& output) const
+	{
+		if (bin.GetLoadState() != Spek::File::LoadState::Loaded)
+			return false;
+
+		const std::vector<u8>& data = bin.GetFile()->GetData();
+		return Write(data.data(), data.size(), output);
+	}
+
+	bool BinTextWriter::Write(const u8* data, size_t size, std::ostream& stream) const
+	{
+		std::string buffer;
+		buffer.reserve(StreamBlockSize * 2);
+		return Write(data, size, buffer, &stream);
+	}
+
+	bool BinTextWriter::Write(const u8* data, size_t size, std::string& output, std::ostream* stream) const
+	{
+		if (size < 8 || memcmp(data, "PROP", 4) != 0)
+			return false;
+
+		u32 version;
+		memcpy(&version, data + 4, sizeof(version));
+
+		Visitor visitor(*this, output, stream);
+		visitor.Begin(version);
+		if (BinParser::Parse(data, size, visitor) != BinParser::Result::Finished)
+		{
+			visitor.Flush(true);
+			return false;
+		}
+
+		visitor.End();
+		return true;
+	}
+
+	size_t BinTextWriter::Write(const std::vector<const WAD*>& archives, const OnFileFunction& onFile) const
+	{
+		BinArchiveFiles files(archives, m_fileFilter);
+		return files.ForEach([this, &onFile](const BinArchiveFiles::File& file, const std::vector<u8> (&data)[2])
+		{
+			thread_local std::string text;
+			text.clear();
+			if (Write(data[0].data(), data[0].size(), text) == false)
+				return false;
+
+			if (onFile)
+				onFile(*file.archives[0], file.hash, text);
+			return true;
+		});
+	}
+
+	size_t BinTextWriter::Write(const WADFileSystem& fileSystem, const OnFileFunction& onFile) const
+	{
+		return Write(BinArchiveFiles::GetArchives(fileSystem), onFile);
+	}
+}
@@ -0,0 +1,68 @@
+#include <league_lib/bin/bin_type_scan.hpp>
+
+#include <algorithm>
+
+namespace LeagueLib
+{
+	BinTypeScan::BinTypeScan(std::initializer_list<u32> typeHashes)
+	{
+		for (u32 typeHash : typeHashes)
+			AddType(typeHash);
+	}
+
+	BinTypeScan::BinTypeScan(std::initializer_list<BinFieldKey> typeKeys)
+	{
+		for (BinFieldKey typeKey : typeKeys)
+			AddType(typeKey);
+	}
+
+	BinTypeScan& BinTypeScan::AddType(u32 typeHash)
+	{
+		auto position = std::lower_bound(m_typeHashes.begin(), m_typeHashes.end(), typeHash);
+		if (position == m_typeHashes.end() || *position != typeHash)
+			m_typeHashes.insert(position, typeHash);
+		return *this;
+	}
+
+	BinTypeScan& BinTypeScan::SetFileFilter(FileFilterFunction filter)
+	{
+		m_fileFilter = std::move(filter);
+		return *this;
+	}
+
+	bool BinTypeScan::HasType(u32 typeHash) const
+	{
+		return std::binary_search(m_typeHashes.begin(), m_typeHashes.end(), typeHash);
+	}
+
+	bool BinTypeScan::Scan(const u8* data, size_t size, const OnMatchFunction& onMatch) const
+	{
+		return Scan(nullptr, 0, data, size, onMatch);
+	}
+
+	bool BinTypeScan::Scan(const WAD* archive, WAD::FileNameHash fileHash, const u8* data, size_t size, const OnMatchFunction& onMatch) const
+	{
+		Bin::Header header;
+		if (Bin::ReadHeader(data, size, header) == false)
+			return false;
+
+		for (const Bin::Entry& entry : header.entries)
+			if (m_typeHashes.empty() || HasType(entry.typeHash))
+				onMatch({ archive, fileHash, entry, data, size });
+		return true;
+	}
+
+	size_t BinTypeScan::Scan(const std::vector<const WAD*>& archives, const OnMatchFunction& onMatch) const
+	{
+		BinArchiveFiles files(archives, m_fileFilter);
+		return files.ForEach([this, &onMatch](const BinArchiveFiles::File& file, const std::vector<u8> (&data)[2])
+		{
+			return Scan(file.archives[0], file.hash, data[0].data(), data[0].size(), onMatch);
+		});
+	}
+
+	size_t BinTypeScan::Scan(const WADFileSystem& fileSystem, const OnMatchFunction& onMatch) const
+	{
+		return Scan(BinArchiveFiles::GetArchives(fileSystem), onMatch);
+	}
+}
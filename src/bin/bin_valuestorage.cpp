@@ -1,75 +1,110 @@
 #include "league_lib/bin/bin_valuestorage.hpp"
 #include "league_lib/bin/bin.hpp"
+#include "league_lib/util/hash.hpp"
 
 #include <glm/glm.hpp>
+#include <glm/ext/vector_uint4_sized.hpp>
 
 #include <algorithm>
+#include <cassert>
+#include <cstring>
 
 namespace LeagueLib
 {
 	using namespace Spek;
 
-	uint32_t FNV1Hash(const std::string& string)
+	static_assert(sizeof(BinVariable) == 24, "BinVariable is expected to be a compact node");
+
+	bool BinVariableCompare::operator() (BinVarRef lhs, BinVarRef rhs) const
+	{
+		// Different types are ordered by their type index, so that maps can still hold them.
+		if (lhs.GetTypeIndex() != rhs.GetTypeIndex())
+			return lhs.GetTypeIndex() < rhs.GetTypeIndex();
+
+		return lhs.Visit([&rhs](auto&& left)
+		{
+			using Type = DECAY_TYPE(left);
+			assert(IS_TYPE(left, BinArray) == false); // Can't be object
+			assert(IS_TYPE(left, BinObject) == false); // Can't be array
+			assert(IS_TYPE(left, BinMap) == false); // Can't be map
+
+			if constexpr (std::is_arithmetic_v<Type> || std::is_same_v<Type, BinString>)
+			{
+				return left < *rhs.As<Type>();
+			}
+			else if constexpr (std::is_same_v<Type, Colour>)
+			{
+				const Colour& right = *rhs.As<Colour>();
+				return std::tie(left.r, left.g, left.b, left.a) < std::tie(right.r, right.g, right.b, right.a);
+			}
+			else if constexpr (std::is_same_v<Type, glm::mat4>)
+			{
+				const glm::mat4& right = *rhs.As<glm::mat4>();
+				return std::lexicographical_compare(&left[0][0], &left[0][0] + 16, &right[0][0], &right[0][0] + 16);
+			}
+			else if constexpr (std::is_same_v<Type, std::monostate> || std::is_same_v<Type, BinArray> || std::is_same_v<Type, BinObject> || std::is_same_v<Type, BinMap>)
+			{
+				return false;
+			}
+			else
+			{
+				// Vectors are compared component by component.
+				const Type& right = *rhs.As<Type>();
+				return std::lexicographical_compare(&left[0], &left[0] + left.length(), &right[0], &right[0] + right.length());
+			}
+		});
+	}
+
+	// Most objects only have a handful of fields, where a linear scan beats a binary search.
+	template<typename Iterator>
+	static Iterator FindVariable(Iterator begin, Iterator end, u32 hash)
 	{
-		uint32_t currentHash = 0x811c9dc5;
-		const char* chars = string.c_str();
-		for (size_t i = 0; i < string.length(); i++)
-			currentHash = ((currentHash ^ tolower(chars[i])) * 0x01000193) % 0x100000000;
+		constexpr ptrdiff_t linearSearchLimit = 8;
+		if (end - begin <= linearSearchLimit)
+		{
+			for (auto i = begin; i != end; ++i)
+				if (i->first >= hash)
+					return i;
+			return end;
+		}
 
-		return currentHash;
+		return std::lower_bound(begin, end, hash, [](const auto& variable, u32 hash) { return variable.first < hash; });
 	}
 
-	bool BinVariableCompare::operator() (BinVarRef lhs, BinVarRef rhs) const
+	void BinObject::SetVariables(Map&& variables)
 	{
-		return std::visit([](auto&& lhs, auto&& rhs)
-		{
-			assert(MATCHES_TYPE(lhs, rhs)); // Types have to match
-			assert(IS_TYPE(lhs, BinArray) == false); // Can't be object
-			assert(IS_TYPE(lhs, BinObject) == false); // Can't be array
-			assert(IS_TYPE(lhs, BinMap) == false); // Can't be map
-			assert(IS_TYPE(lhs, std::monostate) == false); // Can't be monostate
-
-			/*
-			TODO:
-			Colour
-			glm::vec2
-			glm::vec3
-			glm::vec4
-			glm::ivec2
-			glm::ivec3
-			glm::ivec4
-			glm::mat4
-			*/
-
-#define DEFAULT_COMPARISON(Type) if constexpr (IS_TYPE(lhs, Type))\
-			{\
-				const Type& left = reinterpret_cast<const Type&>(lhs);\
-				const Type& right = reinterpret_cast<const Type&>(rhs);\
-				return left < right;\
-			}
+		m_variables = std::move(variables);
 
-			DEFAULT_COMPARISON(i8)
-			DEFAULT_COMPARISON(i16)
-			DEFAULT_COMPARISON(i32)
-			DEFAULT_COMPARISON(i64)
-			DEFAULT_COMPARISON(u8)
-			DEFAULT_COMPARISON(u16)
-			DEFAULT_COMPARISON(u32)
-			DEFAULT_COMPARISON(u64)
-			DEFAULT_COMPARISON(double)
-			DEFAULT_COMPARISON(std::string)
+		auto compare = [](const auto& left, const auto& right) { return left.first < right.first; };
+		if (std::is_sorted(m_variables.begin(), m_variables.end(), compare))
+		{
+			if (std::adjacent_find(m_variables.begin(), m_variables.end(), [](const auto& left, const auto& right) { return left.first == right.first; }) == m_variables.end())
+				return;
+		}
+		else
+		{
+			std::stable_sort(m_variables.begin(), m_variables.end(), compare);
+		}
 
-			assert(false); // TODO: Should be unreachable
-			return false;
+		// Keep the last of every run of duplicate hashes.
+		auto output = m_variables.begin();
+		for (auto i = m_variables.begin(); i != m_variables.end(); ++i)
+		{
+			auto next = i + 1;
+			if (next != m_variables.end() && next->first == i->first)
+				continue;
 
-#undef DEFAULT_COMPARISON
-		}, lhs, rhs);
+			if (output != i)
+				*output = std::move(*i);
+			++output;
+		}
+		m_variables.erase(output, m_variables.end());
 	}
 
 	const BinVariable& BinObject::operator[](u32 hash) const
 	{
 		static BinVariable none;
-		auto result = m_variables.find(hash);
+		auto result = find(hash);
 		if (result == m_variables.end())
 			return none;
 
@@ -78,24 +113,50 @@ namespace LeagueLib
 
 	const BinVariable& BinObject::operator[](std::string_view name) const
 	{
-		return operator[](FNV1Hash(name.data()));
+		return operator[](HashName(name));
+	}
+
+	const BinVariable& BinObject::operator[](BinFieldKey key) const
+	{
+		return operator[](key.hash);
 	}
 
 	BinVariable& BinObject::operator[](u32 hash)
 	{
-		return m_variables[hash];
+		auto result = FindVariable(m_variables.begin(), m_variables.end(), hash);
+		if (result == m_variables.end() || result->first != hash)
+			result = m_variables.emplace(result, hash, BinVariable());
+
+		return result->second;
 	}
 
 	BinVariable& BinObject::operator[](std::string_view name)
 	{
-		return operator[](FNV1Hash(name.data()));
+		return operator[](HashName(name));
+	}
+
+	BinVariable& BinObject::operator[](BinFieldKey key)
+	{
+		return operator[](key.hash);
+	}
+
+	BinObject::Map::const_iterator BinObject::find(u32 hash) const
+	{
+		auto result = FindVariable(m_variables.begin(), m_variables.end(), hash);
+		return result != m_variables.end() && result->first == hash ? result : m_variables.end();
+	}
+
+	BinObject::Map::iterator BinObject::find(u32 hash)
+	{
+		auto result = FindVariable(m_variables.begin(), m_variables.end(), hash);
+		return result != m_variables.end() && result->first == hash ? result : m_variables.end();
 	}
 
-	BinObject::Map::const_iterator	BinObject::find(u32 hash) const	{ return m_variables.find(hash); }
-	BinObject::Map::iterator		BinObject::find(u32 hash)		{ return m_variables.find(hash); }
+	BinObject::Map::const_iterator	BinObject::find(std::string_view name) const { return find(HashName(name)); }
+	BinObject::Map::iterator		BinObject::find(std::string_view name)		 { return find(HashName(name)); }
 
-	BinObject::Map::const_iterator	BinObject::find(std::string_view name) const { return m_variables.find(FNV1Hash(name.data())); }
-	BinObject::Map::iterator		BinObject::find(std::string_view name)		 { return m_variables.find(FNV1Hash(name.data()));}
+	BinObject::Map::const_iterator	BinObject::find(BinFieldKey key) const	{ return find(key.hash); }
+	BinObject::Map::iterator		BinObject::find(BinFieldKey key)		{ return find(key.hash); }
 
 	BinObject::Map::const_iterator	BinObject::begin() const { return m_variables.begin(); }
 	BinObject::Map::iterator		BinObject::begin()		 { return m_variables.begin(); }
@@ -103,36 +164,487 @@ namespace LeagueLib
 	BinObject::Map::const_iterator	BinObject::end() const	{ return m_variables.end(); }
 	BinObject::Map::iterator		BinObject::end()		{ return m_variables.end(); }
 
-	BinVarRef BinVariable::operator[](size_t index) const
+	static constexpr u64 SignBit = 1ull << 63;
+
+	// Returns false if key isn't an integer. Signed values are returned as their two's complement.
+	static bool GetIntegerKey(const BinVariable& key, u64& result)
 	{
-		return std::visit([index](auto&& variable) -> BinVarRef
+		return key.Visit([&result](auto&& value)
 		{
-			static BinVariable none;
-			if constexpr (IS_TYPE(variable, BinArray))
+			using Type = DECAY_TYPE(value);
+			if constexpr (std::is_integral_v<Type>)
+			{
+				result = std::is_signed_v<Type> ? (u64)(i64)value : (u64)value;
+				return true;
+			}
+			else
 			{
-				const BinArray& currentArray = reinterpret_cast<const BinArray&>(variable);
-				return index < currentArray.size() ? currentArray[index] : none;
+				return false;
 			}
+		});
+	}
 
-			return none;
-		}, (BinVariant&)*this);
+	static bool IsIntegerType(u8 typeIndex)
+	{
+		return typeIndex >= BinTypeIndex<i8> && typeIndex <= BinTypeIndex<u64>;
 	}
 
-	BinVarRef BinVariable::operator[](std::string_view name) const
+	// Signed keys are offset so that they sort like unsigned ones.
+	static u64 ToSortKey(u8 typeIndex, u64 key)
+	{
+		return typeIndex <= BinTypeIndex<i64> ? key ^ SignBit : key;
+	}
+
+	void BinMap::SetPairs(Storage&& pairs)
+	{
+		m_pairs = std::move(pairs);
+
+		BinVariableCompare less;
+		auto compare = [&less](const Pair& left, const Pair& right) { return less(left.first, right.first); };
+		if (std::is_sorted(m_pairs.begin(), m_pairs.end(), compare) == false)
+			std::stable_sort(m_pairs.begin(), m_pairs.end(), compare);
+
+		// Keep the last of every run of duplicate keys.
+		auto output = m_pairs.begin();
+		for (auto i = m_pairs.begin(); i != m_pairs.end(); ++i)
+		{
+			auto next = i + 1;
+			if (next != m_pairs.end() && compare(*i, *next) == false)
+				continue;
+
+			if (output != i)
+				*output = std::move(*i);
+			++output;
+		}
+		m_pairs.erase(output, m_pairs.end());
+
+		IndexKeys();
+	}
+
+	void BinMap::insert_or_assign(BinVariable&& key, BinVariable&& value)
+	{
+		BinVariableCompare less;
+		auto position = std::lower_bound(m_pairs.begin(), m_pairs.end(), key, [&less](const Pair& pair, const BinVariable& key) { return less(pair.first, key); });
+		if (position != m_pairs.end() && less(key, position->first) == false)
+			position->second = std::move(value);
+		else
+			m_pairs.emplace(position, std::move(key), std::move(value));
+
+		IndexKeys();
+	}
+
+	void BinMap::IndexKeys()
+	{
+		m_integerKeys.clear();
+		m_keyType = m_pairs.empty() ? 0 : (u8)m_pairs.front().first.GetTypeIndex();
+		for (const Pair& pair : m_pairs)
+		{
+			if (pair.first.GetTypeIndex() != m_keyType)
+			{
+				m_keyType = MixedKeys;
+				break;
+			}
+		}
+
+		if (IsIntegerType(m_keyType) == false)
+			return;
+
+		m_integerKeys.reserve(m_pairs.size());
+		for (const Pair& pair : m_pairs)
+		{
+			u64 key = 0;
+			GetIntegerKey(pair.first, key);
+			m_integerKeys.push_back(ToSortKey(m_keyType, key));
+		}
+	}
+
+	BinMap::Storage::const_iterator BinMap::find(u64 key) const
+	{
+		if (IsIntegerType(m_keyType))
+		{
+			u64 sortKey = ToSortKey(m_keyType, key);
+			auto result = std::lower_bound(m_integerKeys.begin(), m_integerKeys.end(), sortKey);
+			return result != m_integerKeys.end() && *result == sortKey ? m_pairs.begin() + (result - m_integerKeys.begin()) : m_pairs.end();
+		}
+
+		if (m_keyType == MixedKeys)
+		{
+			for (auto i = m_pairs.begin(); i != m_pairs.end(); ++i)
+			{
+				u64 pairKey;
+				if (GetIntegerKey(i->first, pairKey) && pairKey == key)
+					return i;
+			}
+		}
+
+		return m_pairs.end();
+	}
+
+	BinMap::Storage::const_iterator BinMap::find(BinFieldKey key) const
+	{
+		u64 signedKey = (u64)(i64)(i32)key.hash;
+		if (m_keyType == BinTypeIndex<i32>)
+			return find(signedKey);
+
+		if (m_keyType == MixedKeys)
+		{
+			for (auto i = m_pairs.begin(); i != m_pairs.end(); ++i)
+			{
+				u64 pairKey;
+				if (GetIntegerKey(i->first, pairKey) && pairKey == (i->first.GetTypeIndex() == BinTypeIndex<i32> ? signedKey : (u64)key.hash))
+					return i;
+			}
+			return m_pairs.end();
+		}
+
+		return find((u64)key.hash);
+	}
+
+	BinMap::Storage::const_iterator BinMap::find(std::string_view key) const
+	{
+		if (m_keyType == BinTypeIndex<BinString>)
+		{
+			auto result = std::lower_bound(m_pairs.begin(), m_pairs.end(), key, [](const Pair& pair, std::string_view key) { return *pair.first.As<BinString>() < key; });
+			return result != m_pairs.end() && *result->first.As<BinString>() == key ? result : m_pairs.end();
+		}
+
+		if (m_keyType == MixedKeys)
+		{
+			for (auto i = m_pairs.begin(); i != m_pairs.end(); ++i)
+			{
+				const BinString* pairKey = i->first.As<BinString>();
+				if (pairKey && *pairKey == key)
+					return i;
+			}
+		}
+
+		return m_pairs.end();
+	}
+
+	BinMap::Storage::const_iterator BinMap::find(const BinVariable& key) const
 	{
-		return std::visit([name](auto&& variable) -> BinVarRef
+		u64 integerKey;
+		if (GetIntegerKey(key, integerKey))
+			return find(integerKey);
+
+		if (const BinString* stringKey = key.As<BinString>())
+			return find(*stringKey);
+
+		BinVariableCompare less;
+		auto result = std::lower_bound(m_pairs.begin(), m_pairs.end(), key, [&less](const Pair& pair, const BinVariable& key) { return less(pair.first, key); });
+		return result != m_pairs.end() && less(key, result->first) == false ? result : m_pairs.end();
+	}
+
+	const BinVariable& BinMap::operator[](const BinVariable& key) const
+	{
+		static const BinVariable none;
+		auto result = find(key);
+		return result != m_pairs.end() ? result->second : none;
+	}
+
+	const BinVariable& BinMap::operator[](u64 key) const
+	{
+		static const BinVariable none;
+		auto result = find(key);
+		return result != m_pairs.end() ? result->second : none;
+	}
+
+	const BinVariable& BinMap::operator[](BinFieldKey key) const
+	{
+		static const BinVariable none;
+		auto result = find(key);
+		return result != m_pairs.end() ? result->second : none;
+	}
+
+	const BinVariable& BinMap::operator[](std::string_view key) const
+	{
+		static const BinVariable none;
+		auto result = find(key);
+		return result != m_pairs.end() ? result->second : none;
+	}
+
+	struct BinVariable::LazyValue
+	{
+		const BinLazySource* source;
+		size_t offset;
+		u8 fileType;
+		u8 typeIndex;
+		std::atomic<bool> isParsed = false;
+		BinVariable value;
+	};
+
+	BinVariable BinVariable::MakeLazy(const BinLazySource& source, size_t offset, u8 fileType, u8 typeIndex, std::pmr::memory_resource* resource)
+	{
+		BinVariable result;
+		void* memory = resource->allocate(sizeof(Block<LazyValue>), alignof(Block<LazyValue>));
+		result.m_block = new (memory) Block<LazyValue>{ resource, { &source, offset, fileType, typeIndex, false, BinVariable() } };
+		result.m_type = LazyType;
+		return result;
+	}
+
+	struct BinVariable::TypedArray
+	{
+		BinType elementType;
+		u32 count;
+		std::once_flag isExpanded;
+		BinVariable array;
+	};
+
+	// The elements are stored right after the block.
+	static constexpr size_t TypedArrayAlignment = 16;
+
+	template<typename Block>
+	static constexpr size_t GetTypedArrayDataOffset()
+	{
+		return (sizeof(Block) + TypedArrayAlignment - 1) & ~(TypedArrayAlignment - 1);
+	}
+
+	template<typename T>
+	static T Load(const u8* data)
+	{
+		T value;
+		memcpy(&value, data, sizeof(T));
+		return value;
+	}
+
+	// Creates the same values as reading the element from the file would.
+	static BinVariable MakeElement(BinType type, const u8* data)
+	{
+		switch (type)
+		{
+		case BinType::Bool:
+		case BinType::Flag:		return (bool)Load<u8>(data);
+		case BinType::S8:		return Load<i8>(data);
+		case BinType::U8:		return Load<u8>(data);
+		case BinType::S16:		return Load<i16>(data);
+		case BinType::U16:		return Load<u16>(data);
+		case BinType::S32:		return Load<i32>(data);
+		case BinType::U32:
+		case BinType::Hash:
+		case BinType::Link:		return Load<u32>(data);
+		case BinType::S64:		return Load<i64>(data);
+		case BinType::U64:
+		case BinType::Path:		return Load<u64>(data);
+		case BinType::Float:	return Load<float>(data);
+		case BinType::Vec2f:	return Load<glm::vec2>(data);
+		case BinType::Vec3f:	return Load<glm::vec3>(data);
+		case BinType::Vec4f:	return Load<glm::vec4>(data);
+		case BinType::RGBA:		return glm::ivec4(Load<glm::u8vec4>(data));
+		case BinType::Mat4:		return Load<glm::mat4>(data);
+
+		default:
+			return BinVariable();
+		}
+	}
+
+	BinVariable BinVariable::MakeTypedArray(BinType elementType, const void* data, u32 count, std::pmr::memory_resource* resource)
+	{
+		size_t dataOffset = GetTypedArrayDataOffset<Block<TypedArray>>();
+		size_t dataSize = GetBinTypeSize(elementType) * count;
+		assert(GetBinTypeSize(elementType) != 0);
+
+		BinVariable result;
+		u8* memory = static_cast<u8*>(resource->allocate(dataOffset + dataSize, TypedArrayAlignment));
+		result.m_block = new (memory) Block<TypedArray>{ resource, { elementType, count, {}, BinVariable() } };
+		result.m_type = TypedArrayType;
+		if (dataSize != 0)
+			memcpy(memory + dataOffset, data, dataSize);
+		return result;
+	}
+
+	const void* BinVariable::GetTypedArray(BinType& elementType, u32& count) const
+	{
+		if (m_type == LazyType)
+			return Resolve().GetTypedArray(elementType, count);
+		if (m_type != TypedArrayType)
+			return nullptr;
+
+		const TypedArray& typed = static_cast<const Block<TypedArray>*>(m_block)->value;
+		elementType = typed.elementType;
+		count = typed.count;
+		return static_cast<const u8*>(m_block) + GetTypedArrayDataOffset<Block<TypedArray>>();
+	}
+
+	const BinVariable& BinVariable::Resolve() const
+	{
+		if (m_type == TypedArrayType)
+		{
+			// The BinArray goes to the default resource, as the arena the elements are in isn't thread-safe.
+			TypedArray& typed = static_cast<Block<TypedArray>*>(m_block)->value;
+			std::call_once(typed.isExpanded, [this, &typed]()
+			{
+				const u8* data = static_cast<const u8*>(m_block) + GetTypedArrayDataOffset<Block<TypedArray>>();
+				size_t elementSize = GetBinTypeSize(typed.elementType);
+
+				BinArray array;
+				array.reserve(typed.count);
+				for (u32 i = 0; i < typed.count; i++)
+					array.push_back(MakeElement(typed.elementType, data + i * elementSize));
+				typed.array = BinVariable(std::move(array));
+			});
+			return typed.array;
+		}
+
+		LazyValue& lazy = static_cast<Block<LazyValue>*>(m_block)->value;
+		if (lazy.isParsed.load(std::memory_order_acquire) == false)
 		{
-			static BinVariable none;
-			if constexpr (IS_TYPE(variable, BinObject))
+			std::lock_guard lock(lazy.source->m_mutex);
+			if (lazy.isParsed.load(std::memory_order_relaxed) == false)
 			{
-				const BinObject& currentObject = reinterpret_cast<const BinObject&>(variable);
-				auto index = currentObject.find(FNV1Hash(name.data()));
-				return index != currentObject.end() ? index->second : none;
+				lazy.value = lazy.source->Parse(lazy.offset, lazy.fileType);
+				lazy.isParsed.store(true, std::memory_order_release);
 			}
+		}
 
+		return lazy.value;
+	}
+
+	BinVariable BinVariable::MakeOwnedString(BinString value, std::pmr::memory_resource* resource)
+	{
+		// Empty strings have nothing to borrow.
+		if (value.empty())
+			return BinString();
+
+		BinVariable result;
+		u8* memory = static_cast<u8*>(resource->allocate(sizeof(Block<BinString>) + value.size(), alignof(Block<BinString>)));
+		char* characters = reinterpret_cast<char*>(memory + sizeof(Block<BinString>));
+		memcpy(characters, value.data(), value.size());
+		result.m_block = new (memory) Block<BinString>{ resource, BinString(characters, value.size()) };
+		result.m_type = OwnedStringType;
+		return result;
+	}
+
+	size_t BinVariable::GetTypeIndex() const
+	{
+		if (m_type == LazyType)
+			return static_cast<const Block<LazyValue>*>(m_block)->value.typeIndex;
+		if (m_type == TypedArrayType)
+			return BinTypeIndex<BinArray>;
+		if (m_type == OwnedStringType)
+			return BinTypeIndex<BinString>;
+		return m_type;
+	}
+
+	BinVariable::BinVariable(const BinVariable& other) : m_type(0)
+	{
+		// Typed arrays stay typed, rather than being copied as the BinArray they act as.
+		const BinVariable& source = other.m_type == LazyType ? other.Resolve() : other;
+		if (source.m_type == TypedArrayType)
+		{
+			BinType elementType;
+			u32 count;
+			const void* data = source.GetTypedArray(elementType, count);
+			*this = MakeTypedArray(elementType, data, count, std::pmr::get_default_resource());
+			return;
+		}
+
+		// Strings are copied as well, so that the copy doesn't borrow them from the Bin.
+		if (const BinString* string = source.As<BinString>())
+		{
+			*this = MakeOwnedString(*string, std::pmr::get_default_resource());
+			return;
+		}
+
+		source.Visit([this](auto&& value) { Construct(value, std::pmr::get_default_resource()); });
+	}
+
+	BinVariable::BinVariable(BinVariable&& other) noexcept : m_type(other.m_type)
+	{
+		// Inline values are trivially copyable, and blocks are simply handed over.
+		memcpy(m_data, other.m_data, sizeof(m_data));
+		other.m_type = 0;
+	}
+
+	BinVariable& BinVariable::operator=(const BinVariable& other)
+	{
+		if (this != &other)
+			*this = BinVariable(other);
+		return *this;
+	}
+
+	BinVariable& BinVariable::operator=(BinVariable&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Destroy();
+			memcpy(m_data, other.m_data, sizeof(m_data));
+			m_type = other.m_type;
+			other.m_type = 0;
+		}
+		return *this;
+	}
+
+	void BinVariable::Destroy()
+	{
+		// Don't go through Visit, that would parse lazy values just to destroy them.
+		if (m_type == LazyType)
+		{
+			Block<LazyValue>* block = static_cast<Block<LazyValue>*>(m_block);
+			std::pmr::memory_resource* resource = block->resource;
+			block->~Block<LazyValue>();
+			resource->deallocate(block, sizeof(Block<LazyValue>), alignof(Block<LazyValue>));
+			m_type = 0;
+			return;
+		}
+
+		if (m_type == TypedArrayType)
+		{
+			Block<TypedArray>* block = static_cast<Block<TypedArray>*>(m_block);
+			std::pmr::memory_resource* resource = block->resource;
+			size_t size = GetTypedArrayDataOffset<Block<TypedArray>>() + GetBinTypeSize(block->value.elementType) * block->value.count;
+			block->~Block<TypedArray>();
+			resource->deallocate(block, size, TypedArrayAlignment);
+			m_type = 0;
+			return;
+		}
+
+		if (m_type == OwnedStringType)
+		{
+			Block<BinString>* block = static_cast<Block<BinString>*>(m_block);
+			std::pmr::memory_resource* resource = block->resource;
+			size_t size = sizeof(Block<BinString>) + block->value.size();
+			block->~Block<BinString>();
+			resource->deallocate(block, size, alignof(Block<BinString>));
+			m_type = 0;
+			return;
+		}
+
+		Visit([this](auto&& value)
+		{
+			using Type = DECAY_TYPE(value);
+			if constexpr (IsInline<Type> == false)
+			{
+				Block<Type>* block = static_cast<Block<Type>*>(m_block);
+				std::pmr::memory_resource* resource = block->resource;
+				block->~Block<Type>();
+				resource->deallocate(block, sizeof(Block<Type>), alignof(Block<Type>));
+			}
+		});
+		m_type = 0;
+	}
+
+	BinVarRef BinVariable::operator[](size_t index) const
+	{
+		static const BinVariable none;
+		const BinArray* currentArray = As<BinArray>();
+		return currentArray && index < currentArray->size() ? (*currentArray)[index] : none;
+	}
+
+	BinVarRef BinVariable::operator[](std::string_view name) const
+	{
+		return operator[](BinFieldKey(HashName(name)));
+	}
+
+	BinVarRef BinVariable::operator[](BinFieldKey key) const
+	{
+		static const BinVariable none;
+		const BinObject* currentObject = As<BinObject>();
+		if (currentObject == nullptr)
 			return none;
-		}, *this);
+
+		auto index = currentObject->find(key);
+		return index != currentObject->end() ? index->second : none;
 	}
 
-	bool BinVariable::IsValid() const { return !Is<std::monostate>(); }
+	bool BinVariable::IsValid() const { return m_type != BinTypeIndex<std::monostate>; }
 }
@@ -0,0 +1,689 @@
+#include <league_lib/bin/bin_writer.hpp>
+
+#include <glm/ext/vector_uint4_sized.hpp>
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+namespace LeagueLib
+{
+	// The type a value of a file type ends up as when it's parsed.
+	static size_t GetParsedTypeIndex(BinType type)
+	{
+		switch (type)
+		{
+		case BinType::Bool:
+		case BinType::Flag:
+		case BinType::S32:			return BinTypeIndex<i32>;
+		case BinType::S8:			return BinTypeIndex<i8>;
+		case BinType::U8:			return BinTypeIndex<u8>;
+		case BinType::S16:			return BinTypeIndex<i16>;
+		case BinType::U16:			return BinTypeIndex<u16>;
+		case BinType::U32:
+		case BinType::Hash:
+		case BinType::Link:			return BinTypeIndex<u32>;
+		case BinType::S64:			return BinTypeIndex<i64>;
+		case BinType::U64:
+		case BinType::Path:			return BinTypeIndex<u64>;
+		case BinType::Float:		return BinTypeIndex<double>;
+		case BinType::Vec2f:		return BinTypeIndex<glm::vec2>;
+		case BinType::Vec3f:		return BinTypeIndex<glm::vec3>;
+		case BinType::Vec4f:		return BinTypeIndex<glm::vec4>;
+		case BinType::Mat4:			return BinTypeIndex<glm::mat4>;
+		case BinType::RGBA:			return BinTypeIndex<glm::ivec4>;
+		case BinType::String:		return BinTypeIndex<BinString>;
+		case BinType::Struct:
+		case BinType::Embedded:		return BinTypeIndex<BinObject>;
+		case BinType::Container:
+		case BinType::Container2:
+		case BinType::Array:		return BinTypeIndex<BinArray>;
+		case BinType::Map:			return BinTypeIndex<BinMap>;
+		default:					return (size_t)-1;
+		}
+	}
+
+	static bool IsCompatible(BinType type, const BinVariable& value)
+	{
+		return GetParsedTypeIndex(type) == value.GetTypeIndex();
+	}
+
+	// The file type of a parsed value whose type isn't known, or Empty if it has none.
+	static BinType GetDefaultType(const BinVariable& value)
+	{
+		switch (value.GetTypeIndex())
+		{
+		case BinTypeIndex<i8>:			return BinType::S8;
+		case BinTypeIndex<i16>:			return BinType::S16;
+		case BinTypeIndex<i32>:			return BinType::S32;
+		case BinTypeIndex<i64>:			return BinType::S64;
+		case BinTypeIndex<u8>:			return BinType::U8;
+		case BinTypeIndex<u16>:			return BinType::U16;
+		case BinTypeIndex<u32>:			return BinType::U32;
+		case BinTypeIndex<u64>:			return BinType::U64;
+		case BinTypeIndex<double>:		return BinType::Float;
+		case BinTypeIndex<BinString>:	return BinType::String;
+		case BinTypeIndex<glm::vec2>:	return BinType::Vec2f;
+		case BinTypeIndex<glm::vec3>:	return BinType::Vec3f;
+		case BinTypeIndex<glm::vec4>:	return BinType::Vec4f;
+		case BinTypeIndex<glm::ivec4>:	return BinType::RGBA;
+		case BinTypeIndex<glm::mat4>:	return BinType::Mat4;
+		case BinTypeIndex<BinObject>:	return value.As<BinObject>()->GetTypeHash() != 0 ? BinType::Embedded : BinType::Struct;
+		case BinTypeIndex<BinMap>:		return BinType::Map;
+		case BinTypeIndex<BinArray>:	return BinType::Container;
+		default:						return BinType::Empty;
+		}
+	}
+
+	// Collects the types of the fields of every class, see BinWriter::AddTypes.
+	class BinWriter::TypeCollector : public BinVisitor
+	{
+	public:
+		TypeCollector(std::unordered_map<u32, std::unordered_map<u32, FieldType>>& classes) : m_classes(classes) {}
+
+		Action OnBeginEntry(u32, u32 typeHash) override
+		{
+			m_frames.push_back({ typeHash });
+			return Enter;
+		}
+
+		Action OnEndEntry(u32) override
+		{
+			m_frames.pop_back();
+			return Enter;
+		}
+
+		Action OnField(u32 hash, BinType type) override
+		{
+			m_field = &m_classes[m_frames.back().typeHash][hash];
+			m_field->type = type;
+			return Enter;
+		}
+
+		Action OnValue(const BinValueView&) override
+		{
+			EndValue();
+			return Enter;
+		}
+
+		Action OnBeginStruct(u32 typeHash) override
+		{
+			m_frames.push_back({ typeHash });
+			return Enter;
+		}
+
+		Action OnEndStruct() override
+		{
+			m_frames.pop_back();
+			EndValue();
+			return Enter;
+		}
+
+		Action OnBeginContainer(BinType, BinType elementType, u32) override
+		{
+			if (FieldType* field = GetField())
+				field->elementType = elementType;
+			else if (Frame& parent = m_frames.back(); parent.field && parent.isKey == false)
+				parent.field->valueElementType = elementType;
+
+			m_frames.push_back({});
+			return Enter;
+		}
+
+		Action OnEndContainer() override
+		{
+			m_frames.pop_back();
+			EndValue();
+			return Enter;
+		}
+
+		Action OnBeginMap(BinType keyType, BinType valueType, u32) override
+		{
+			FieldType* field = GetField();
+			if (field)
+			{
+				field->elementType = keyType;
+				field->valueType = valueType;
+			}
+
+			m_frames.push_back({ 0, field, true });
+			return Enter;
+		}
+
+		Action OnEndMap() override
+		{
+			m_frames.pop_back();
+			EndValue();
+			return Enter;
+		}
+
+	private:
+		struct Frame
+		{
+			u32 typeHash = 0; // Structs
+			FieldType* field = nullptr; // Maps that are the value of a field
+			bool isKey = true;
+		};
+
+		// The field whose value is being begun, if it's directly in a struct.
+		FieldType* GetField() const
+		{
+			return m_frames.back().typeHash != 0 ? m_field : nullptr;
+		}
+
+		void EndValue()
+		{
+			if (m_frames.empty() == false)
+				m_frames.back().isKey = !m_frames.back().isKey;
+		}
+
+		std::unordered_map<u32, std::unordered_map<u32, FieldType>>& m_classes;
+		std::vector<Frame> m_frames;
+		FieldType* m_field = nullptr;
+	};
+
+	bool BinWriter::AddTypes(const u8* data, size_t size)
+	{
+		TypeCollector collector(m_classes);
+		return BinParser::Parse(data, size, collector) == BinParser::Result::Finished;
+	}
+
+	void BinWriter::AddLinkedFile(std::string_view name)
+	{
+		m_linkedFiles.emplace_back(name);
+	}
+
+	void BinWriter::BeginEntry(u32 hash, u32 typeHash)
+	{
+		assert(m_frames.empty());
+		m_typeArray.push_back(typeHash);
+
+		size_t lengthOffset = m_data.size();
+		Append<u32>(0);
+		Append(hash);
+		m_frames.push_back({ Frame::Kind::Fields, lengthOffset, m_data.size() });
+		Append<u16>(0);
+	}
+
+	void BinWriter::EndEntry()
+	{
+		assert(m_frames.size() == 1);
+		EndFrame();
+	}
+
+	void BinWriter::WriteField(u32 hash, BinType type)
+	{
+		assert(m_frames.empty() == false && m_frames.back().kind == Frame::Kind::Fields);
+		m_frames.back().count++;
+		Append(hash);
+		Append(type);
+	}
+
+	void BinWriter::WriteValue(const BinValueView& value)
+	{
+		CountValue();
+		Append(value.data, value.size);
+	}
+
+	void BinWriter::WriteString(std::string_view value)
+	{
+		assert(value.size() <= 0xFFFF);
+		CountValue();
+		Append((u16)value.size());
+		Append(value.data(), value.size());
+	}
+
+	void BinWriter::BeginStruct(u32 typeHash)
+	{
+		CountValue();
+		Append(typeHash);
+		if (typeHash == 0)
+		{
+			m_frames.push_back({ Frame::Kind::Null, 0, 0 });
+			return;
+		}
+
+		size_t lengthOffset = m_data.size();
+		Append<u32>(0);
+		m_frames.push_back({ Frame::Kind::Fields, lengthOffset, m_data.size() });
+		Append<u16>(0);
+	}
+
+	void BinWriter::EndStruct()
+	{
+		assert(m_frames.size() > 1 && (m_frames.back().kind == Frame::Kind::Fields || m_frames.back().kind == Frame::Kind::Null));
+		EndFrame();
+	}
+
+	void BinWriter::BeginContainer(BinType type, BinType elementType)
+	{
+		CountValue();
+		Append(elementType);
+		if (type == BinType::Array)
+		{
+			m_frames.push_back({ Frame::Kind::Array, 0, m_data.size() });
+			Append<u8>(0);
+			return;
+		}
+
+		size_t lengthOffset = m_data.size();
+		Append<u32>(0);
+		m_frames.push_back({ Frame::Kind::Container, lengthOffset, m_data.size() });
+		Append<u32>(0);
+	}
+
+	void BinWriter::EndContainer()
+	{
+		assert(m_frames.empty() == false && (m_frames.back().kind == Frame::Kind::Container || m_frames.back().kind == Frame::Kind::Array));
+		EndFrame();
+	}
+
+	void BinWriter::BeginMap(BinType keyType, BinType valueType)
+	{
+		CountValue();
+		Append(keyType);
+		Append(valueType);
+
+		size_t lengthOffset = m_data.size();
+		Append<u32>(0);
+		m_frames.push_back({ Frame::Kind::Map, lengthOffset, m_data.size() });
+		Append<u32>(0);
+	}
+
+	void BinWriter::EndMap()
+	{
+		assert(m_frames.empty() == false && m_frames.back().kind == Frame::Kind::Map && m_frames.back().isKey);
+		EndFrame();
+	}
+
+	void BinWriter::CountValue()
+	{
+		assert(m_frames.empty() == false);
+		Frame& frame = m_frames.back();
+		switch (frame.kind)
+		{
+		case Frame::Kind::Container:
+		case Frame::Kind::Array:
+			frame.count++;
+			break;
+
+		case Frame::Kind::Map:
+			if (frame.isKey)
+				frame.count++;
+			frame.isKey = !frame.isKey;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	void BinWriter::EndFrame()
+	{
+		Frame frame = m_frames.back();
+		m_frames.pop_back();
+
+		// Lengths start right after themselves.
+		if (frame.kind != Frame::Kind::Array && frame.kind != Frame::Kind::Null)
+		{
+			u32 length = (u32)(m_data.size() - frame.lengthOffset - sizeof(u32));
+			memcpy(m_data.data() + frame.lengthOffset, &length, sizeof(length));
+		}
+
+		switch (frame.kind)
+		{
+		case Frame::Kind::Fields:
+		{
+			assert(frame.count <= 0xFFFF);
+			u16 count = (u16)frame.count;
+			memcpy(m_data.data() + frame.countOffset, &count, sizeof(count));
+			break;
+		}
+
+		case Frame::Kind::Array:
+		{
+			assert(frame.count <= 0xFF);
+			u8 count = (u8)frame.count;
+			memcpy(m_data.data() + frame.countOffset, &count, sizeof(count));
+			break;
+		}
+
+		case Frame::Kind::Container:
+		case Frame::Kind::Map:
+			memcpy(m_data.data() + frame.countOffset, &frame.count, sizeof(frame.count));
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	void BinWriter::Append(const void* data, size_t size)
+	{
+		const u8* bytes = static_cast<const u8*>(data);
+		m_data.insert(m_data.end(), bytes, bytes + size);
+	}
+
+	const BinWriter::FieldType* BinWriter::FindFieldType(u32 typeHash, u32 fieldHash) const
+	{
+		auto fields = m_classes.find(typeHash);
+		if (fields == m_classes.end())
+			return nullptr;
+
+		auto field = fields->second.find(fieldHash);
+		return field != fields->second.end() ? &field->second : nullptr;
+	}
+
+	void BinWriter::WriteEntry(u32 hash, const BinObject& object)
+	{
+		BeginEntry(hash, object.GetTypeHash());
+		WriteFields(object);
+		EndEntry();
+	}
+
+	bool BinWriter::WriteVariable(BinType type, const BinVariable& value)
+	{
+		return WriteVariable(FieldType{ type }, value);
+	}
+
+	void BinWriter::WriteFields(const BinObject& object)
+	{
+		for (const auto& [hash, value] : object)
+		{
+			FieldType type;
+			const FieldType* knownType = FindFieldType(object.GetTypeHash(), hash);
+			if (knownType && IsCompatible(knownType->type, value))
+				type = *knownType;
+			else
+				type.type = GetDefaultType(value);
+
+			if (type.type == BinType::Empty)
+				continue;
+
+			WriteField(hash, type.type);
+			WriteVariable(type, value);
+		}
+	}
+
+	template<typename T>
+	static bool WriteSpan(std::vector<u8>& data, u32& count, const BinVariable& value)
+	{
+		BinSpan<T> span = value.AsSpan<T>();
+		if (span.empty())
+			return false;
+
+		const u8* bytes = reinterpret_cast<const u8*>(span.data());
+		data.insert(data.end(), bytes, bytes + span.size() * sizeof(T));
+		count += (u32)span.size();
+		return true;
+	}
+
+	// Copies the elements of a typed array as they are, if they have the element type.
+	bool BinWriter::WriteTypedArray(BinType elementType, const BinVariable& value)
+	{
+		u32& count = m_frames.back().count;
+		switch (elementType)
+		{
+		case BinType::Bool:
+		case BinType::Flag:
+		case BinType::U8:		return WriteSpan<u8>(m_data, count, value);
+		case BinType::S8:		return WriteSpan<i8>(m_data, count, value);
+		case BinType::S16:		return WriteSpan<i16>(m_data, count, value);
+		case BinType::U16:		return WriteSpan<u16>(m_data, count, value);
+		case BinType::S32:		return WriteSpan<i32>(m_data, count, value);
+		case BinType::U32:
+		case BinType::Hash:
+		case BinType::Link:		return WriteSpan<u32>(m_data, count, value);
+		case BinType::S64:		return WriteSpan<i64>(m_data, count, value);
+		case BinType::U64:
+		case BinType::Path:		return WriteSpan<u64>(m_data, count, value);
+		case BinType::Float:	return WriteSpan<float>(m_data, count, value);
+		case BinType::Vec2f:	return WriteSpan<glm::vec2>(m_data, count, value);
+		case BinType::Vec3f:	return WriteSpan<glm::vec3>(m_data, count, value);
+		case BinType::Vec4f:	return WriteSpan<glm::vec4>(m_data, count, value);
+		case BinType::RGBA:		return WriteSpan<glm::u8vec4>(m_data, count, value);
+		case BinType::Mat4:		return WriteSpan<glm::mat4>(m_data, count, value);
+		default:				return false;
+		}
+	}
+
+	bool BinWriter::WriteVariable(const FieldType& type, const BinVariable& value)
+	{
+		if (IsCompatible(type.type, value) == false)
+			return false;
+
+		switch (type.type)
+		{
+		case BinType::Bool:
+		case BinType::Flag:
+		{
+			u8 boolean = *value.As<i32>() != 0;
+			WriteValue(type.type, boolean);
+			break;
+		}
+
+		case BinType::S8:		WriteValue(type.type, *value.As<i8>()); break;
+		case BinType::U8:		WriteValue(type.type, *value.As<u8>()); break;
+		case BinType::S16:		WriteValue(type.type, *value.As<i16>()); break;
+		case BinType::U16:		WriteValue(type.type, *value.As<u16>()); break;
+		case BinType::S32:		WriteValue(type.type, *value.As<i32>()); break;
+		case BinType::U32:
+		case BinType::Hash:
+		case BinType::Link:		WriteValue(type.type, *value.As<u32>()); break;
+		case BinType::S64:		WriteValue(type.type, *value.As<i64>()); break;
+		case BinType::U64:
+		case BinType::Path:		WriteValue(type.type, *value.As<u64>()); break;
+		case BinType::Float:	WriteValue(type.type, (float)*value.As<double>()); break;
+		case BinType::Vec2f:	WriteValue(type.type, *value.As<glm::vec2>()); break;
+		case BinType::Vec3f:	WriteValue(type.type, *value.As<glm::vec3>()); break;
+		case BinType::Vec4f:	WriteValue(type.type, *value.As<glm::vec4>()); break;
+		case BinType::Mat4:		WriteValue(type.type, *value.As<glm::mat4>()); break;
+		case BinType::RGBA:		WriteValue(type.type, glm::u8vec4(*value.As<glm::ivec4>())); break;
+		case BinType::String:	WriteString(*value.As<BinString>()); break;
+
+		case BinType::Struct:
+		case BinType::Embedded:
+		{
+			const BinObject& object = *value.As<BinObject>();
+			BeginStruct(object.GetTypeHash());
+			if (object.GetTypeHash() != 0)
+				WriteFields(object);
+			EndStruct();
+			break;
+		}
+
+		case BinType::Container:
+		case BinType::Container2:
+		case BinType::Array:
+		{
+			BinType elementType = type.elementType;
+			if (elementType == BinType::Empty)
+			{
+				const BinArray& array = *value.As<BinArray>();
+				elementType = array.empty() ? BinType::U32 : GetDefaultType(array.front());
+			}
+
+			BeginContainer(type.type, elementType);
+			if (WriteTypedArray(elementType, value) == false)
+			{
+				for (const BinVariable& element : *value.As<BinArray>())
+					WriteVariable(FieldType{ elementType }, element);
+			}
+			EndContainer();
+			break;
+		}
+
+		case BinType::Map:
+		{
+			const BinMap& map = *value.As<BinMap>();
+			FieldType keyType = { type.elementType };
+			FieldType valueType = { type.valueType, type.valueElementType };
+			if (keyType.type == BinType::Empty || valueType.type == BinType::Empty)
+			{
+				keyType = { map.empty() ? BinType::U32 : GetDefaultType(map.begin()->first) };
+				valueType = { map.empty() ? BinType::U32 : GetDefaultType(map.begin()->second) };
+			}
+
+			BeginMap(keyType.type, valueType.type);
+			for (const auto& [key, pairValue] : map)
+			{
+				if (IsCompatible(keyType.type, key) == false || IsCompatible(valueType.type, pairValue) == false)
+					continue;
+
+				WriteVariable(keyType, key);
+				WriteVariable(valueType, pairValue);
+			}
+			EndMap();
+			break;
+		}
+
+		default:
+			return false;
+		}
+
+		return true;
+	}
+
+	void BinWriter::Finish(std::vector<u8>& output)
+	{
+		assert(m_frames.empty());
+
+		size_t headerSize = 4 + sizeof(u32) * 3 + m_typeArray.size() * sizeof(u32);
+		for (const std::string& linkedFile : m_linkedFiles)
+			headerSize += sizeof(u16) + linkedFile.size();
+
+		output.clear();
+		output.reserve(headerSize + m_data.size());
+
+		auto append = [&output](const void* data, size_t size)
+		{
+			const u8* bytes = static_cast<const u8*>(data);
+			output.insert(output.end(), bytes, bytes + size);
+		};
+
+		u32 version = 3;
+		u32 linkedFileCount = (u32)m_linkedFiles.size();
+		u32 entryCount = (u32)m_typeArray.size();
+		append("PROP", 4);
+		append(&version, sizeof(version));
+		append(&linkedFileCount, sizeof(linkedFileCount));
+		for (const std::string& linkedFile : m_linkedFiles)
+		{
+			u16 length = (u16)linkedFile.size();
+			append(&length, sizeof(length));
+			append(linkedFile.data(), linkedFile.size());
+		}
+		append(&entryCount, sizeof(entryCount));
+		append(m_typeArray.data(), m_typeArray.size() * sizeof(u32));
+		append(m_data.data(), m_data.size());
+
+		m_linkedFiles.clear();
+		m_typeArray.clear();
+		m_data.clear();
+	}
+
+	bool BinWriter::Save(const std::string& path)
+	{
+		std::vector<u8> data;
+		Finish(data);
+
+		std::ofstream fileStream(path, std::ofstream::binary | std::ofstream::trunc);
+		if (!fileStream)
+			return false;
+
+		fileStream.write(reinterpret_cast<const char*>(data.data()), data.size());
+		return fileStream.good();
+	}
+
+	bool BinWriter::Write(const Bin& bin, std::vector<u8>& output)
+	{
+		if (bin.GetLoadState() != Spek::File::LoadState::Loaded)
+			return false;
+
+		BinWriter writer;
+		const std::vector<u8>& data = bin.GetFile()->GetData();
+		if (writer.AddTypes(data.data(), data.size()) == false)
+			return false;
+
+		for (const std::string& linkedFile : bin.GetLinkedFiles())
+			writer.AddLinkedFile(linkedFile);
+
+		for (const Bin::Entry& entry : bin.GetEntries())
+		{
+			const BinObject* object = bin[entry.hash].As<BinObject>();
+			if (object == nullptr)
+				return false;
+
+			writer.WriteEntry(entry.hash, *object);
+		}
+
+		writer.Finish(output);
+		return true;
+	}
+
+	BinVisitor::Action BinWriter::OnLinkedFile(std::string_view name)
+	{
+		AddLinkedFile(name);
+		return Enter;
+	}
+
+	BinVisitor::Action BinWriter::OnBeginEntry(u32 hash, u32 typeHash)
+	{
+		BeginEntry(hash, typeHash);
+		return Enter;
+	}
+
+	BinVisitor::Action BinWriter::OnEndEntry(u32)
+	{
+		EndEntry();
+		return Enter;
+	}
+
+	BinVisitor::Action BinWriter::OnField(u32 hash, BinType type)
+	{
+		WriteField(hash, type);
+		return Enter;
+	}
+
+	BinVisitor::Action BinWriter::OnValue(const BinValueView& value)
+	{
+		WriteValue(value);
+		return Enter;
+	}
+
+	BinVisitor::Action BinWriter::OnBeginStruct(u32 typeHash)
+	{
+		BeginStruct(typeHash);
+		return Enter;
+	}
+
+	BinVisitor::Action BinWriter::OnEndStruct()
+	{
+		EndStruct();
+		return Enter;
+	}
+
+	BinVisitor::Action BinWriter::OnBeginContainer(BinType type, BinType elementType, u32)
+	{
+		BeginContainer(type, elementType);
+		return Enter;
+	}
+
+	BinVisitor::Action BinWriter::OnEndContainer()
+	{
+		EndContainer();
+		return Enter;
+	}
+
+	BinVisitor::Action BinWriter::OnBeginMap(BinType keyType, BinType valueType, u32)
+	{
+		BeginMap(keyType, valueType);
+		return Enter;
+	}
+
+	BinVisitor::Action BinWriter::OnEndMap()
+	{
+		EndMap();
+		return Enter;
+	}
+}
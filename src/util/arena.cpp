@@ -0,0 +1,71 @@
+#include "league_lib/util/arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace LeagueLib
+{
+	constexpr size_t MaxArenaBlockSize = 4 * 1024 * 1024;
+
+	Arena::Arena(size_t inBlockSize) :
+		m_blockSize(std::max<size_t>(inBlockSize, 256))
+	{
+	}
+
+	Arena::~Arena()
+	{
+		Release();
+		if (m_blocks)
+			::operator delete(m_blocks);
+	}
+
+	void Arena::Release()
+	{
+		if (m_blocks == nullptr)
+			return;
+
+		Block* block = m_blocks->next;
+		while (block)
+		{
+			Block* next = block->next;
+			::operator delete(block);
+			block = next;
+		}
+
+		m_blocks->next = nullptr;
+		m_current = (u8*)(m_blocks + 1);
+		m_end = (u8*)m_blocks + m_blocks->size;
+		m_usedBytes = 0;
+		m_reservedBytes = m_blocks->size;
+	}
+
+	void Arena::AddBlock(size_t inMinimumSize)
+	{
+		size_t size = std::max(m_blockSize, inMinimumSize + sizeof(Block));
+		m_blockSize = std::min(m_blockSize * 2, MaxArenaBlockSize);
+
+		Block* block = (Block*)::operator new(size);
+		block->next = m_blocks;
+		block->size = size;
+		m_blocks = block;
+
+		m_current = (u8*)(block + 1);
+		m_end = (u8*)block + size;
+		m_reservedBytes += size;
+	}
+
+	void* Arena::do_allocate(size_t inBytes, size_t inAlignment)
+	{
+		uintptr_t aligned = ((uintptr_t)m_current + inAlignment - 1) & ~(uintptr_t)(inAlignment - 1);
+		if (m_current == nullptr || aligned + inBytes > (uintptr_t)m_end)
+		{
+			AddBlock(inBytes + inAlignment);
+			aligned = ((uintptr_t)m_current + inAlignment - 1) & ~(uintptr_t)(inAlignment - 1);
+		}
+
+		m_current = (u8*)(aligned + inBytes);
+		m_usedBytes += inBytes;
+		return (void*)aligned;
+	}
+}
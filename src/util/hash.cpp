@@ -0,0 +1,218 @@
+#include "league_lib/util/hash.hpp"
+
+#include <cstring>
+
+namespace LeagueLib
+{
+	namespace
+	{
+		using HashInternal::XXH64Prime1;
+		using HashInternal::XXH64Prime2;
+		using HashInternal::XXH64Prime3;
+		using HashInternal::XXH64Prime4;
+		using HashInternal::XXH64Prime5;
+		using HashInternal::RotateLeft;
+		using HashInternal::XXH64Round;
+		using HashInternal::XXH64Merge;
+
+		constexpr u32 FNVOffset = 0x811c9dc5;
+		constexpr u32 FNVPrime = 0x01000193;
+
+		constexpr u64 RepeatByte(u8 inByte) { return 0x0101010101010101ULL * inByte; }
+
+		// Lowercases all eight ASCII characters of a word at once. Bytes outside of 'A'-'Z' are untouched,
+		// including UTF-8 bytes, to match the per-character tolower the game uses.
+		inline u64 ToLower(u64 inWord)
+		{
+			u64 ascii = inWord & RepeatByte(0x7F);
+			u64 aboveZ = ascii + RepeatByte(0x7F - 'Z');
+			u64 atLeastA = ascii + RepeatByte(0x80 - 'A');
+			u64 isUpper = (atLeastA ^ aboveZ) & ~inWord & RepeatByte(0x80);
+			return inWord | (isUpper >> 2);
+		}
+
+		inline u8 ToLower(u8 inChar)
+		{
+			return (inChar >= 'A' && inChar <= 'Z') ? inChar + ('a' - 'A') : inChar;
+		}
+
+		inline u64 ReadLower64(const char* inData)
+		{
+			u64 result;
+			memcpy(&result, inData, sizeof(u64));
+			return ToLower(result);
+		}
+
+		inline u64 ReadLower32(const char* inData)
+		{
+			u32 result;
+			memcpy(&result, inData, sizeof(u32));
+			return ToLower((u64)result);
+		}
+
+		inline u64 Read64(const char* inData)
+		{
+			u64 result;
+			memcpy(&result, inData, sizeof(u64));
+			return result;
+		}
+
+		inline u64 Read32(const char* inData)
+		{
+			u32 result;
+			memcpy(&result, inData, sizeof(u32));
+			return result;
+		}
+
+		// XXH64 with seed 0, over the lowercased input if IsLowercased, without copying it first.
+		template<bool IsLowercased>
+		u64 XXH64(const char* inData, size_t inLength)
+		{
+			auto read64 = [](const char* inWord) { return IsLowercased ? ReadLower64(inWord) : Read64(inWord); };
+			auto read32 = [](const char* inWord) { return IsLowercased ? ReadLower32(inWord) : Read32(inWord); };
+			auto read8 = [](char inChar) { return IsLowercased ? ToLower((u8)inChar) : (u8)inChar; };
+
+			const char* current = inData;
+			const char* end = inData + inLength;
+
+			u64 hash;
+			if (inLength >= 32)
+			{
+				u64 lane1 = XXH64Prime1 + XXH64Prime2;
+				u64 lane2 = XXH64Prime2;
+				u64 lane3 = 0;
+				u64 lane4 = 0 - XXH64Prime1;
+
+				for (; current + 32 <= end; current += 32)
+				{
+					lane1 = XXH64Round(lane1, read64(current));
+					lane2 = XXH64Round(lane2, read64(current + 8));
+					lane3 = XXH64Round(lane3, read64(current + 16));
+					lane4 = XXH64Round(lane4, read64(current + 24));
+				}
+
+				hash = RotateLeft(lane1, 1) + RotateLeft(lane2, 7) + RotateLeft(lane3, 12) + RotateLeft(lane4, 18);
+				hash = XXH64Merge(hash, lane1);
+				hash = XXH64Merge(hash, lane2);
+				hash = XXH64Merge(hash, lane3);
+				hash = XXH64Merge(hash, lane4);
+			}
+			else
+			{
+				hash = XXH64Prime5;
+			}
+
+			hash += inLength;
+
+			for (; current + 8 <= end; current += 8)
+			{
+				hash ^= XXH64Round(0, read64(current));
+				hash = RotateLeft(hash, 27) * XXH64Prime1 + XXH64Prime4;
+			}
+
+			if (current + 4 <= end)
+			{
+				hash ^= read32(current) * XXH64Prime1;
+				hash = RotateLeft(hash, 23) * XXH64Prime2 + XXH64Prime3;
+				current += 4;
+			}
+
+			for (; current < end; current++)
+			{
+				hash ^= read8(*current) * XXH64Prime5;
+				hash = RotateLeft(hash, 11) * XXH64Prime1;
+			}
+
+			hash ^= hash >> 33;
+			hash *= XXH64Prime2;
+			hash ^= hash >> 29;
+			hash *= XXH64Prime3;
+			hash ^= hash >> 32;
+			return hash;
+		}
+
+		inline u32 FNVStep(u32 inHash, u64 inWord, int inByte)
+		{
+			return (inHash ^ (u8)(inWord >> (inByte * 8))) * FNVPrime;
+		}
+
+		inline u32 FNVWord(u32 inHash, u64 inWord)
+		{
+			for (int i = 0; i < 8; i++)
+				inHash = FNVStep(inHash, inWord, i);
+			return inHash;
+		}
+
+		u32 FNVLower(u32 inHash, const char* inData, size_t inLength)
+		{
+			size_t i = 0;
+			for (; i + 8 <= inLength; i += 8)
+				inHash = FNVWord(inHash, ReadLower64(inData + i));
+
+			for (; i < inLength; i++)
+				inHash = (inHash ^ ToLower((u8)inData[i])) * FNVPrime;
+			return inHash;
+		}
+	}
+
+	u64 HashPath(std::string_view inPath)
+	{
+		return XXH64<true>(inPath.data(), inPath.size());
+	}
+
+	u64 HashData(const void* inData, size_t inSize)
+	{
+		return XXH64<false>(static_cast<const char*>(inData), inSize);
+	}
+
+	u32 HashName(std::string_view inName)
+	{
+		return FNVLower(FNVOffset, inName.data(), inName.size());
+	}
+
+	void HashPaths(const std::string_view* inPaths, size_t inCount, u64* outHashes)
+	{
+		// XXH64 already runs four independent lanes per stripe, so the paths are simply hashed one by one.
+		for (size_t i = 0; i < inCount; i++)
+			outHashes[i] = XXH64<true>(inPaths[i].data(), inPaths[i].size());
+	}
+
+	void HashNames(const std::string_view* inNames, size_t inCount, u32* outHashes)
+	{
+		// FNV-1a is one long dependency chain per name, so we interleave four names to keep the multiplier busy,
+		// for as long as all four of them have whole words left.
+		size_t i = 0;
+		for (; i + 4 <= inCount; i += 4)
+		{
+			const std::string_view* names = inNames + i;
+			size_t sharedLength = names[0].size();
+			for (int lane = 1; lane < 4; lane++)
+				sharedLength = names[lane].size() < sharedLength ? names[lane].size() : sharedLength;
+			sharedLength &= ~(size_t)7;
+
+			u32 hash0 = FNVOffset, hash1 = FNVOffset, hash2 = FNVOffset, hash3 = FNVOffset;
+			for (size_t offset = 0; offset < sharedLength; offset += 8)
+			{
+				u64 word0 = ReadLower64(names[0].data() + offset);
+				u64 word1 = ReadLower64(names[1].data() + offset);
+				u64 word2 = ReadLower64(names[2].data() + offset);
+				u64 word3 = ReadLower64(names[3].data() + offset);
+				for (int byte = 0; byte < 8; byte++)
+				{
+					hash0 = FNVStep(hash0, word0, byte);
+					hash1 = FNVStep(hash1, word1, byte);
+					hash2 = FNVStep(hash2, word2, byte);
+					hash3 = FNVStep(hash3, word3, byte);
+				}
+			}
+
+			outHashes[i + 0] = FNVLower(hash0, names[0].data() + sharedLength, names[0].size() - sharedLength);
+			outHashes[i + 1] = FNVLower(hash1, names[1].data() + sharedLength, names[1].size() - sharedLength);
+			outHashes[i + 2] = FNVLower(hash2, names[2].data() + sharedLength, names[2].size() - sharedLength);
+			outHashes[i + 3] = FNVLower(hash3, names[3].data() + sharedLength, names[3].size() - sharedLength);
+		}
+
+		for (; i < inCount; i++)
+			outHashes[i] = HashName(inNames[i]);
+	}
+}
@@ -0,0 +1,128 @@
+#include "league_lib/util/mapped_file.hpp"
+
+#include <utility>
+
+#if defined(_WIN32)
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace LeagueLib
+{
+	MappedFile::MappedFile(MappedFile&& inOther) noexcept
+	{
+		*this = std::move(inOther);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& inOther) noexcept
+	{
+		if (this == &inOther)
+			return *this;
+
+		Close();
+		std::swap(m_data, inOther.m_data);
+		std::swap(m_size, inOther.m_size);
+#if defined(_WIN32)
+		std::swap(m_fileHandle, inOther.m_fileHandle);
+		std::swap(m_mappingHandle, inOther.m_mappingHandle);
+#endif
+		return *this;
+	}
+
+#if defined(_WIN32)
+	bool MappedFile::Open(const char* inFileName)
+	{
+		Close();
+
+		HANDLE file = CreateFileA(inFileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if (GetFileSizeEx(file, &size) == FALSE || size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (view == nullptr)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		m_fileHandle = file;
+		m_mappingHandle = mapping;
+		m_data = (const u8*)view;
+		m_size = (size_t)size.QuadPart;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_data)
+			UnmapViewOfFile(m_data);
+		if (m_mappingHandle)
+			CloseHandle(m_mappingHandle);
+		if (m_fileHandle)
+			CloseHandle(m_fileHandle);
+
+		m_data = nullptr;
+		m_size = 0;
+		m_fileHandle = nullptr;
+		m_mappingHandle = nullptr;
+	}
+#else
+	bool MappedFile::Open(const char* inFileName)
+	{
+		Close();
+
+		int file = open(inFileName, O_RDONLY);
+		if (file < 0)
+			return false;
+
+		struct stat fileStat;
+		if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+		{
+			close(file);
+			return false;
+		}
+
+		void* view = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		close(file); // The mapping keeps its own reference to the file
+		if (view == MAP_FAILED)
+			return false;
+
+		m_data = (const u8*)view;
+		m_size = (size_t)fileStat.st_size;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_data)
+			munmap((void*)m_data, m_size);
+
+		m_data = nullptr;
+		m_size = 0;
+	}
+#endif
+}
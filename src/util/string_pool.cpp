@@ -0,0 +1,81 @@
+#include "league_lib/util/string_pool.hpp"
+#include "league_lib/util/hash.hpp"
+
+#include <cstring>
+#include <mutex>
+
+namespace LeagueLib
+{
+	StringPool& StringPool::GetDefault()
+	{
+		static StringPool pool;
+		return pool;
+	}
+
+	std::string_view StringPool::Intern(std::string_view inString)
+	{
+		if (inString.empty())
+			return std::string_view();
+
+		// The top bits pick the shard, the set uses the bottom ones for its buckets.
+		Key key = { HashData(inString.data(), inString.size()), inString };
+		Shard& shard = m_shards[key.hash >> 59];
+		shard.internCount.fetch_add(1, std::memory_order_relaxed);
+
+		{
+			std::shared_lock lock(shard.mutex);
+			auto existing = shard.strings.find(key);
+			if (existing != shard.strings.end())
+			{
+				shard.savedBytes.fetch_add(inString.size(), std::memory_order_relaxed);
+				return existing->string;
+			}
+		}
+
+		std::unique_lock lock(shard.mutex);
+
+		// Another thread might have added it while we were waiting for the lock.
+		auto existing = shard.strings.find(key);
+		if (existing != shard.strings.end())
+		{
+			shard.savedBytes.fetch_add(inString.size(), std::memory_order_relaxed);
+			return existing->string;
+		}
+
+		char* copy = (char*)shard.arena.allocate(inString.size(), 1);
+		memcpy(copy, inString.data(), inString.size());
+		key.string = std::string_view(copy, inString.size());
+
+		shard.strings.insert(key);
+		shard.stringBytes += inString.size();
+		return key.string;
+	}
+
+	StringPool::Stats StringPool::GetStats() const
+	{
+		Stats stats = {};
+		for (const Shard& shard : m_shards)
+		{
+			std::shared_lock lock(shard.mutex);
+			stats.stringCount += shard.strings.size();
+			stats.stringBytes += shard.stringBytes;
+			stats.reservedBytes += shard.arena.GetReservedBytes();
+			stats.internCount += shard.internCount.load(std::memory_order_relaxed);
+			stats.savedBytes += shard.savedBytes.load(std::memory_order_relaxed);
+		}
+		return stats;
+	}
+
+	void StringPool::Clear()
+	{
+		for (Shard& shard : m_shards)
+		{
+			std::unique_lock lock(shard.mutex);
+			shard.strings = {};
+			shard.arena.Release();
+			shard.stringBytes = 0;
+			shard.internCount = 0;
+			shard.savedBytes = 0;
+		}
+	}
+}
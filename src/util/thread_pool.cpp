@@ -0,0 +1,126 @@
+#include "league_lib/util/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace LeagueLib
+{
+	ThreadPool::ThreadPool(size_t inThreadCount)
+	{
+		if (inThreadCount == 0)
+			inThreadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		m_threads.reserve(inThreadCount);
+		for (size_t i = 0; i < inThreadCount; i++)
+			m_threads.emplace_back([this]() { WorkerLoop(); });
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_isStopping = true;
+		}
+
+		m_condition.notify_all();
+		for (auto& thread : m_threads)
+			thread.join();
+	}
+
+	ThreadPool& ThreadPool::GetDefault()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+
+	void ThreadPool::Submit(Task inTask)
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_tasks.push_back(std::move(inTask));
+		}
+
+		m_condition.notify_one();
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			Task task;
+			{
+				std::unique_lock lock(m_mutex);
+				m_condition.wait(lock, [this]() { return m_isStopping || m_tasks.empty() == false; });
+				if (m_tasks.empty())
+					return;
+
+				task = std::move(m_tasks.front());
+				m_tasks.pop_front();
+			}
+
+			task();
+		}
+	}
+
+	void ThreadPool::ParallelFor(size_t inCount, size_t inGrainSize, const RangeFunction& inFunction)
+	{
+		if (inCount == 0)
+			return;
+
+		inGrainSize = std::max<size_t>(inGrainSize, 1);
+		size_t rangeCount = (inCount + inGrainSize - 1) / inGrainSize;
+		if (rangeCount == 1)
+		{
+			inFunction(0, inCount);
+			return;
+		}
+
+		// Helpers can still be queued after we return, so the state they share with us is reference counted.
+		// They only touch inFunction after claiming a range, which can only happen while we're still waiting.
+		struct SharedState
+		{
+			std::atomic<size_t> nextRange { 0 };
+			size_t finishedRanges = 0;
+			std::exception_ptr exception;
+			std::mutex mutex;
+			std::condition_variable condition;
+		};
+		auto state = std::make_shared<SharedState>();
+
+		auto runRanges = [state, rangeCount, inCount, inGrainSize, function = &inFunction]()
+		{
+			for (size_t range = state->nextRange++; range < rangeCount; range = state->nextRange++)
+			{
+				std::exception_ptr exception;
+				try
+				{
+					size_t begin = range * inGrainSize;
+					(*function)(begin, std::min(begin + inGrainSize, inCount));
+				}
+				catch (...)
+				{
+					exception = std::current_exception();
+				}
+
+				std::lock_guard lock(state->mutex);
+				if (exception && state->exception == nullptr)
+					state->exception = exception;
+				if (++state->finishedRanges == rangeCount)
+					state->condition.notify_all();
+			}
+		};
+
+		size_t helperCount = std::min(rangeCount - 1, GetThreadCount());
+		for (size_t i = 0; i < helperCount; i++)
+			Submit(runRanges);
+
+		runRanges();
+
+		std::unique_lock lock(state->mutex);
+		state->condition.wait(lock, [&state, rangeCount]() { return state->finishedRanges == rangeCount; });
+		if (state->exception)
+			std::rethrow_exception(state->exception);
+	}
+}
@@ -1,8 +1,9 @@
 #include "league_lib/wad/wad.hpp"
+#include "league_lib/util/hash.hpp"
 
 #include <spek/util/assert.hpp>
 
-#include <xxhash64.h>
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 
@@ -84,6 +85,7 @@ namespace LeagueLib
 
 		WADv3::Header header;
 		fileStream.read(reinterpret_cast<char*>(&header), sizeof(WADv3::Header));
+		m_checksum = header.checksum;
 
 		for (uint32_t i = 0; i < header.fileCount; i++)
 		{
@@ -117,25 +119,15 @@ namespace LeagueLib
 		return m_fileData.find(inFileHash) != m_fileData.end();
 	}
 
-	uint64_t HashFileName(const char* inFileName)
-	{
-		char fileName[FILENAME_MAX];
-		strncpy(fileName, inFileName, FILENAME_MAX);
-		for (char* c = fileName; *c; c++)
-			*c = tolower(*c);
-
-		return XXHash64::hash(inFileName, strlen(inFileName), 0);
-	}
-
 	bool WAD::HasFile(const char* inFileName) const
 	{
-		uint64_t hash = HashFileName(inFileName);
+		uint64_t hash = HashPath(inFileName);
 		return m_fileData.find(hash) != m_fileData.end();
 	}
 
 	bool WAD::ExtractFile(std::string_view inFileName, std::vector<u8>& inResult) const
 	{
-		return ExtractFile(HashFileName(inFileName.data()), inResult);
+		return ExtractFile(HashPath(inFileName), inResult);
 	}
 
 	bool WAD::ExtractFile(uint64_t inHash, std::vector<u8>& inResult) const
@@ -257,7 +249,7 @@ namespace LeagueLib
 
 	bool WAD::ExtractFile(std::string_view inFileName, u8* inResult) const
 	{
-		return ExtractFile(HashFileName(inFileName.data()), inResult);
+		return ExtractFile(HashPath(inFileName), inResult);
 	}
 
 	bool WAD::ExtractFile(uint64_t inHash, u8* inResult) const
@@ -317,9 +309,92 @@ namespace LeagueLib
 		return false;
 	}
 
+	bool WAD::ExtractFileStart(uint64_t inHash, u8* inResult, size_t inSize) const
+	{
+		const auto& fileDataIterator = m_fileData.find(inHash);
+		if (fileDataIterator == m_fileData.end() || fileDataIterator->second.fileSize < inSize)
+			return false;
+
+		std::ifstream fileStream;
+		fileStream.open(m_fileName.c_str(), std::ifstream::binary);
+
+		const auto& fileData = fileDataIterator->second;
+
+		fileStream.seekg(fileData.offset, fileStream.beg);
+
+		WAD::StorageType type = (WAD::StorageType)(fileData.typeData & 0b1111);
+		size_t compressedSize = fileData.compressedSize;
+		if (type == WAD::StorageType::ZSTD_COMPRESSED_MULTI && m_subchunkStream.empty() == false)
+		{
+			// Only the first subchunk is needed, which is stored as is if it didn't get any smaller.
+			size_t index = fileData.firstSubchunkIndex;
+			if (16 * (index + 1) > m_subchunkStream.size())
+				return false;
+
+			u32 subchunkCompressedSize = *(u32*)(m_subchunkStream.data() + 16 * index);
+			u32 subchunkUncompressedSize = *(u32*)(m_subchunkStream.data() + 16 * index + 4);
+			if (subchunkCompressedSize == subchunkUncompressedSize && subchunkUncompressedSize >= inSize)
+			{
+				fileStream.read((char*)inResult, inSize);
+				return (size_t)fileStream.gcount() == inSize;
+			}
+
+			if (subchunkCompressedSize >= subchunkUncompressedSize)
+			{
+				// A tiny first subchunk, the rest of the start is in the next ones.
+				std::vector<u8> data;
+				if (ExtractFile(inHash, data) == false || data.size() < inSize)
+					return false;
+				memcpy(inResult, data.data(), inSize);
+				return true;
+			}
+
+			compressedSize = subchunkCompressedSize;
+		}
+
+		switch (type)
+		{
+		case WAD::StorageType::UNCOMPRESSED:
+		{
+			fileStream.read((char*)inResult, inSize);
+			return (size_t)fileStream.gcount() == inSize;
+		}
+
+		case WAD::StorageType::ZSTD_COMPRESSED:
+		case WAD::StorageType::ZSTD_COMPRESSED_MULTI:
+		{
+			// Streaming stops as soon as the output is full, which usually means only the first block is decompressed.
+			ZSTD_DCtx* context = ZSTD_createDCtx();
+			ZSTD_outBuffer output = { inResult, inSize, 0 };
+			std::vector<char> compressedData(std::min(compressedSize, ZSTD_DStreamInSize()));
+
+			size_t remaining = compressedSize;
+			bool isValid = true;
+			while (isValid && output.pos < inSize && remaining != 0)
+			{
+				size_t readSize = std::min(remaining, compressedData.size());
+				fileStream.read(compressedData.data(), readSize);
+				if ((size_t)fileStream.gcount() != readSize)
+					break;
+				remaining -= readSize;
+
+				ZSTD_inBuffer input = { compressedData.data(), readSize, 0 };
+				while (isValid && output.pos < inSize && input.pos < input.size)
+					isValid = ZSTD_isError(ZSTD_decompressStream(context, &output, &input)) == false;
+			}
+
+			ZSTD_freeDCtx(context);
+			return output.pos == inSize;
+		}
+
+		default:
+			return false;
+		}
+	}
+
 	size_t WAD::GetFileSize(std::string_view inFileName) const
 	{
-		return GetFileSize(HashFileName(inFileName.data()));
+		return GetFileSize(HashPath(inFileName));
 	}
 
 	size_t WAD::GetFileSize(uint64_t inFileName) const
@@ -331,6 +406,15 @@ namespace LeagueLib
 		return fileDataIterator->second.fileSize;
 	}
 
+	uint64_t WAD::GetFileChecksum(uint64_t inFileHash) const
+	{
+		const auto& fileDataIterator = m_fileData.find(inFileHash);
+		if (fileDataIterator == m_fileData.end())
+			return 0;
+
+		return fileDataIterator->second.checksum;
+	}
+
 	Spek::File::LoadState WAD::GetLoadState() const
 	{
 		return  m_loadState;
@@ -345,5 +429,6 @@ namespace LeagueLib
 		fileSize = inFileData.fileSize;
 		typeData = inFileData.typeData;
 		firstSubchunkIndex = inFileData.firstSubchunkIndex;
+		checksum = inFileData.sha256;
 	}
 }
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "league_lib/wad/wad_filesystem.hpp"
+#include "league_lib/util/hash.hpp"
+#include "league_lib/util/thread_pool.hpp"
 
 #include <spek/util/assert.hpp>
 
@@ -7,8 +9,6 @@
 #include <algorithm>
 #include <fstream>
 
-#include <xxhash64.h>
-
 namespace LeagueLib
 {
 	using namespace Spek;
@@ -45,10 +45,21 @@ namespace LeagueLib
 			auto loadRequests = m_loadRequests;
 			m_loadRequests.clear();
 
-			for (auto& fileToLoad : loadRequests)
+			// Extracting is what takes time, so that's done in parallel. The files are resolved on this thread though,
+			// as that calls back into the code that requested them.
+			std::vector<std::vector<u8>> containers(loadRequests.size());
+			std::vector<u8> isExtracted(loadRequests.size(), false);
+			ThreadPool::GetDefault().ParallelFor(loadRequests.size(), 1, [&loadRequests, &containers, &isExtracted](size_t inBegin, size_t inEnd)
+			{
+				for (size_t i = inBegin; i < inEnd; i++)
+					isExtracted[i] = loadRequests[i].Archive->ExtractFile(loadRequests[i].Hash, containers[i]);
+			});
+
+			for (size_t i = 0; i < loadRequests.size(); i++)
 			{
-				std::vector<u8> container;
-				if (fileToLoad.Archive->ExtractFile(fileToLoad.Name.c_str(), container) == false)
+				auto& fileToLoad = loadRequests[i];
+				std::vector<u8>& container = containers[i];
+				if (isExtracted[i] == false)
 				{
 					SPEK_ASSERT(false, "Was unable to load this file!");
 					ResolveFile(fileToLoad.File, File::LoadState::FailedToLoad);
@@ -60,6 +71,7 @@ namespace LeagueLib
 				// WriteAllBytesToFile(fileToLoad.Name.c_str(), container); // Uncomment for debug files
 
 				ResolveFile(fileToLoad.File, File::LoadState::Loaded);
+				container = std::vector<u8>();
 			}
 		}
 
@@ -132,7 +144,7 @@ namespace LeagueLib
 
 	bool WADFileSystem::Exists(const char* inLocation)
 	{
-		uint64_t hash = XXHash64::hash(inLocation, strlen(inLocation), 0);
+		uint64_t hash = HashPath(inLocation);
 		for (auto& archive : m_archives)
 			if (archive->HasFile(hash))
 				return true;
@@ -156,12 +168,8 @@ namespace LeagueLib
 
 	File::Handle WADFileSystem::GetInternal(const char* inLocation, bool inInvalidate)
 	{
-		// Transform to lowercase
-		std::string location = inLocation;
-		std::transform(location.begin(), location.end(), location.begin(), tolower);
-
 		WAD* containingArchive = nullptr;
-		uint64_t hash = XXHash64::hash(location.c_str(), location.length(), 0);
+		uint64_t hash = HashPath(inLocation);
 		for (auto& archive : m_archives)
 		{
 			if (archive->HasFile(hash))
@@ -179,9 +187,12 @@ namespace LeagueLib
 		bool invalidate = filePointer == nullptr || inInvalidate;
 		if (filePointer == nullptr)
 		{
+			// Transform to lowercase, only needed for the name of new files
+			std::string location = inLocation;
+			std::transform(location.begin(), location.end(), location.begin(), tolower);
 			MakeFile(*this, location.c_str(), filePointer);
 
-			m_loadRequests.push_back({ containingArchive, filePointer, location });
+			m_loadRequests.push_back({ containingArchive, filePointer, location, hash });
 			printf("Requested a load for '%s'.\n", inLocation);
 		}
 		return filePointer;
@@ -0,0 +1,366 @@
+#include "league_lib/wad/wad_hash_dictionary.hpp"
+#include "league_lib/util/hash.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace LeagueLib
+{
+	namespace
+	{
+#pragma pack(push, 1)
+		struct DictionaryHeader
+		{
+			char magic[4]; // LLHD
+			u32 version;
+			u64 count;
+			u32 blockSize;
+			u32 blockCount;
+			u64 hashOffset;
+			u64 blockOffset;
+			u64 stringOffset;
+			u64 stringSize;
+		};
+#pragma pack(pop)
+
+		constexpr u32 DictionaryVersion = 1;
+
+		void WriteVarInt(std::vector<u8>& inOutput, size_t inValue)
+		{
+			while (inValue >= 0x80)
+			{
+				inOutput.push_back((u8)(inValue | 0x80));
+				inValue >>= 7;
+			}
+			inOutput.push_back((u8)inValue);
+		}
+
+		// Returns false if the value runs past inEnd, or doesn't fit in a size_t.
+		bool ReadVarInt(const u8*& inData, const u8* inEnd, size_t& outValue)
+		{
+			outValue = 0;
+			for (int shift = 0; shift < 64 && inData < inEnd; shift += 7)
+			{
+				u8 byte = *inData++;
+				outValue |= (size_t)(byte & 0x7F) << shift;
+				if ((byte & 0x80) == 0)
+					return true;
+			}
+			return false;
+		}
+
+		// Checks that inCount elements of inElementSize starting at inOffset fit in inSize, without overflowing.
+		bool IsRangeValid(u64 inOffset, u64 inCount, u64 inElementSize, size_t inSize)
+		{
+			return inOffset <= inSize && inCount <= (inSize - inOffset) / inElementSize;
+		}
+
+		// Decodes names of one block in order, reusing the previous name for the shared prefix.
+		struct BlockCursor
+		{
+			const u8* data = nullptr;
+			const u8* end = nullptr;
+			size_t block = ~(size_t)0;
+			size_t next = 0;
+			std::string name;
+
+			// Returns false if the names are cut off or corrupt. The block is decoded from its start again on the next seek.
+			bool Seek(const u8* inStrings, size_t inStringSize, const u32* inBlockOffsets, u32 inBlockSize, size_t inIndex)
+			{
+				size_t targetBlock = inIndex / inBlockSize;
+				size_t targetIndex = inIndex % inBlockSize;
+				if (targetBlock != block || targetIndex < next)
+				{
+					block = targetBlock;
+					data = inStrings + inBlockOffsets[block];
+					end = inStrings + inStringSize;
+					next = 0;
+					name.clear();
+				}
+
+				for (; next <= targetIndex; next++)
+				{
+					size_t prefix = 0;
+					size_t suffix;
+					if ((next != 0 && ReadVarInt(data, end, prefix) == false) || ReadVarInt(data, end, suffix) == false ||
+						prefix > name.size() || suffix > (size_t)(end - data))
+					{
+						block = ~(size_t)0;
+						name.clear();
+						return false;
+					}
+
+					name.resize(prefix);
+					name.append((const char*)data, suffix);
+					data += suffix;
+				}
+				return true;
+			}
+		};
+	}
+
+	bool WADHashDictionary::Load(const char* inFileName)
+	{
+		Unload();
+		if (m_mappedFile.Open(inFileName) == false)
+			return false;
+
+		m_data = m_mappedFile.GetData();
+		m_size = m_mappedFile.GetSize();
+		return Validate();
+	}
+
+	bool WADHashDictionary::Load(std::vector<u8>&& inData)
+	{
+		Unload();
+		m_ownedData = std::move(inData);
+		m_data = m_ownedData.data();
+		m_size = m_ownedData.size();
+		return Validate();
+	}
+
+	void WADHashDictionary::Unload()
+	{
+		m_mappedFile.Close();
+		m_ownedData.clear();
+		m_ownedData.shrink_to_fit();
+
+		m_data = nullptr;
+		m_size = 0;
+		m_hashes = nullptr;
+		m_blockOffsets = nullptr;
+		m_strings = nullptr;
+		m_stringSize = 0;
+		m_count = 0;
+		m_blockSize = 0;
+	}
+
+	bool WADHashDictionary::Validate()
+	{
+		if (m_data == nullptr || m_size < sizeof(DictionaryHeader))
+		{
+			Unload();
+			return false;
+		}
+
+		const DictionaryHeader& header = *(const DictionaryHeader*)m_data;
+		bool isValid = memcmp(header.magic, "LLHD", 4) == 0 && header.version == DictionaryVersion && header.blockSize != 0 &&
+			IsRangeValid(header.hashOffset, header.count, sizeof(FileNameHash), m_size) &&
+			IsRangeValid(header.blockOffset, header.blockCount, sizeof(u32), m_size) &&
+			IsRangeValid(header.stringOffset, header.stringSize, 1, m_size) &&
+			header.blockCount == (header.count + header.blockSize - 1) / header.blockSize;
+
+		// Every block has to start within the names, decoding checks the rest as it goes.
+		const u32* blockOffsets = isValid ? (const u32*)(m_data + header.blockOffset) : nullptr;
+		for (u32 i = 0; isValid && i < header.blockCount; i++)
+			isValid = blockOffsets[i] < header.stringSize;
+
+		if (isValid == false)
+		{
+			Unload();
+			return false;
+		}
+
+		m_hashes = (const FileNameHash*)(m_data + header.hashOffset);
+		m_blockOffsets = (const u32*)(m_data + header.blockOffset);
+		m_strings = m_data + header.stringOffset;
+		m_stringSize = header.stringSize;
+		m_count = header.count;
+		m_blockSize = header.blockSize;
+		return true;
+	}
+
+	size_t WADHashDictionary::FindIndex(FileNameHash inHash) const
+	{
+		const FileNameHash* end = m_hashes + m_count;
+		const FileNameHash* result = std::lower_bound(m_hashes, end, inHash);
+		if (result == end || *result != inHash)
+			return ~(size_t)0;
+
+		return result - m_hashes;
+	}
+
+	bool WADHashDictionary::DecodeName(size_t inIndex, std::string& outFileName) const
+	{
+		BlockCursor cursor;
+		if (cursor.Seek(m_strings, m_stringSize, m_blockOffsets, m_blockSize, inIndex) == false)
+			return false;
+
+		outFileName = std::move(cursor.name);
+		return true;
+	}
+
+	bool WADHashDictionary::Has(FileNameHash inHash) const
+	{
+		return IsLoaded() && FindIndex(inHash) != ~(size_t)0;
+	}
+
+	bool WADHashDictionary::Find(FileNameHash inHash, std::string& outFileName) const
+	{
+		if (IsLoaded() == false)
+			return false;
+
+		size_t index = FindIndex(inHash);
+		if (index == ~(size_t)0)
+			return false;
+
+		return DecodeName(index, outFileName);
+	}
+
+	void WADHashDictionary::Resolve(const WAD& inArchive, OnResolveFunction inOnResolve) const
+	{
+		if (inOnResolve == nullptr)
+			return;
+
+		std::vector<std::pair<FileNameHash, const WAD::MinFileData*>> files;
+		for (auto& file : inArchive)
+			files.emplace_back(file.first, &file.second);
+		std::sort(files.begin(), files.end(), [](const auto& inLeft, const auto& inRight) { return inLeft.first < inRight.first; });
+
+		BlockCursor cursor;
+		const FileNameHash* current = m_hashes;
+		const FileNameHash* end = m_hashes + m_count;
+		for (auto& file : files)
+		{
+			current = IsLoaded() ? std::lower_bound(current, end, file.first) : end;
+			if (current == end || *current != file.first)
+			{
+				inOnResolve(file.first, std::string_view(), *file.second);
+				continue;
+			}
+
+			// Names that can't be decoded are passed on as unknown.
+			if (cursor.Seek(m_strings, m_stringSize, m_blockOffsets, m_blockSize, current - m_hashes))
+				inOnResolve(file.first, cursor.name, *file.second);
+			else
+				inOnResolve(file.first, std::string_view(), *file.second);
+		}
+	}
+
+	void WADHashDictionaryBuilder::Add(WAD::FileNameHash inHash, std::string_view inFileName)
+	{
+		m_entries.emplace_back(inHash, std::string(inFileName));
+	}
+
+	void WADHashDictionaryBuilder::Add(std::string_view inFileName)
+	{
+		Add(HashPath(inFileName), inFileName);
+	}
+
+	bool WADHashDictionaryBuilder::AddTextList(const char* inFileName)
+	{
+		std::ifstream fileStream(inFileName, std::ios::binary);
+		if (!fileStream)
+			return false;
+
+		std::string contents((std::istreambuf_iterator<char>(fileStream)), std::istreambuf_iterator<char>());
+		std::string_view text = contents;
+		while (text.empty() == false)
+		{
+			size_t lineEnd = text.find('\n');
+			std::string_view line = text.substr(0, lineEnd);
+			text = lineEnd == std::string_view::npos ? std::string_view() : text.substr(lineEnd + 1);
+
+			if (line.empty() == false && line.back() == '\r')
+				line.remove_suffix(1);
+
+			size_t separator = line.find(' ');
+			if (separator == std::string_view::npos || separator == 0)
+				continue;
+
+			WAD::FileNameHash hash = 0;
+			bool isValid = true;
+			for (char c : line.substr(0, separator))
+			{
+				int digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+				if (digit < 0)
+				{
+					isValid = false;
+					break;
+				}
+				hash = (hash << 4) | (WAD::FileNameHash)digit;
+			}
+
+			if (isValid)
+				Add(hash, line.substr(separator + 1));
+		}
+
+		return true;
+	}
+
+	std::vector<u8> WADHashDictionaryBuilder::Build(u32 inBlockSize) const
+	{
+		if (inBlockSize == 0)
+			inBlockSize = 16;
+
+		std::vector<const std::pair<WAD::FileNameHash, std::string>*> entries;
+		entries.reserve(m_entries.size());
+		for (auto& entry : m_entries)
+			entries.push_back(&entry);
+
+		// Sort by hash and keep the first name that was added for duplicate hashes.
+		std::stable_sort(entries.begin(), entries.end(), [](auto* inLeft, auto* inRight) { return inLeft->first < inRight->first; });
+		entries.erase(std::unique(entries.begin(), entries.end(), [](auto* inLeft, auto* inRight) { return inLeft->first == inRight->first; }), entries.end());
+
+		size_t count = entries.size();
+		u32 blockCount = (u32)((count + inBlockSize - 1) / inBlockSize);
+
+		std::vector<u32> blockOffsets(blockCount);
+		std::vector<u8> strings;
+		for (size_t i = 0; i < count; i++)
+		{
+			const std::string& name = entries[i]->second;
+			if (i % inBlockSize == 0)
+			{
+				blockOffsets[i / inBlockSize] = (u32)strings.size();
+				WriteVarInt(strings, name.size());
+				strings.insert(strings.end(), name.begin(), name.end());
+				continue;
+			}
+
+			const std::string& previous = entries[i - 1]->second;
+			size_t prefix = std::mismatch(name.begin(), name.begin() + std::min(name.size(), previous.size()), previous.begin()).first - name.begin();
+			WriteVarInt(strings, prefix);
+			WriteVarInt(strings, name.size() - prefix);
+			strings.insert(strings.end(), name.begin() + prefix, name.end());
+		}
+
+		DictionaryHeader header;
+		memcpy(header.magic, "LLHD", 4);
+		header.version = DictionaryVersion;
+		header.count = count;
+		header.blockSize = inBlockSize;
+		header.blockCount = blockCount;
+		header.hashOffset = sizeof(DictionaryHeader);
+		header.blockOffset = header.hashOffset + count * sizeof(WAD::FileNameHash);
+		header.stringOffset = header.blockOffset + blockCount * sizeof(u32);
+		header.stringSize = strings.size();
+
+		std::vector<u8> result(header.stringOffset + header.stringSize);
+		memcpy(result.data(), &header, sizeof(DictionaryHeader));
+
+		WAD::FileNameHash* hashes = (WAD::FileNameHash*)(result.data() + header.hashOffset);
+		for (size_t i = 0; i < count; i++)
+			hashes[i] = entries[i]->first;
+
+		if (blockCount != 0)
+			memcpy(result.data() + header.blockOffset, blockOffsets.data(), blockCount * sizeof(u32));
+		if (strings.empty() == false)
+			memcpy(result.data() + header.stringOffset, strings.data(), strings.size());
+		return result;
+	}
+
+	bool WADHashDictionaryBuilder::Write(const char* inFileName, u32 inBlockSize) const
+	{
+		std::vector<u8> data = Build(inBlockSize);
+
+		std::ofstream fileStream(inFileName, std::ios::binary | std::ios::out);
+		if (!fileStream)
+			return false;
+
+		fileStream.write((const char*)data.data(), data.size());
+		return (bool)fileStream;
+	}
+}